@@ -0,0 +1,106 @@
+#include "benchmark.h"
+#include "chunk.h"
+#include "chunkMesh.h"
+#include "chunkPool.h"
+#include "generation.h"
+#include <tracy/Tracy.hpp>
+#include <memory>
+#include <random>
+
+namespace Benchmark {
+	std::vector<SimdResult> runSimd(const int iterations) {
+		ZoneScopedN("SIMD Benchmark");
+
+		using Clock = std::chrono::steady_clock;
+
+		// Worst case for masks, no uniform sections and every type in every row
+		std::mt19937 rng(1337);
+		auto mixedVolume = std::make_unique<VoxelVolume>();
+		for (Voxel& voxel : mixedVolume->voxels) {
+			voxel.type = static_cast<VoxelType>(rng() % static_cast<uint32_t>(VoxelType::COUNT));
+		}
+
+		// Every column type (water, beach and land) with tall columns so most rows get written
+		Generation::HeightMap heights;
+		for (int& height : heights) {
+			height = static_cast<int>(rng() % MAX_HEIGHT);
+		}
+
+		auto terrainVolume = std::make_unique<VoxelVolume>();
+		auto masks = std::make_unique<Masks>();
+
+		std::vector<SimdResult> results;
+
+		for (int levelIndex = 0; levelIndex <= static_cast<int>(Simd::getLevel()); levelIndex++) {
+			SimdResult result;
+			result.level = static_cast<Simd::Level>(levelIndex);
+
+			const Clock::time_point maskStart = Clock::now();
+			for (int i = 0; i < iterations; i++) {
+				Chunk::classifyRows(*mixedVolume, 0, CHUNK_SIZE * MAX_HEIGHT, *masks, result.level);
+			}
+			result.maskTime = (Clock::now() - maskStart) / iterations;
+
+			// Only the fill is timed, clearing is the same for every level
+			for (int i = 0; i < iterations; i++) {
+				terrainVolume->voxels.fill(Voxel{});
+				terrainVolume->voxelCount = 0;
+
+				const Clock::time_point terrainStart = Clock::now();
+				Generation::fillTerrain(heights, *terrainVolume, result.level);
+				result.terrainTime += Clock::now() - terrainStart;
+			}
+			result.terrainTime /= iterations;
+
+			results.push_back(result);
+		}
+
+		return results;
+	}
+
+	MeshingResult runMeshing(const uint32_t seed, const int radius) {
+		ZoneScopedN("Meshing Benchmark");
+
+		using Clock = std::chrono::steady_clock;
+
+		// One ring past the meshed chunks for their neighbors
+		const int side = radius * 2 + 3;
+		std::vector<std::shared_ptr<Chunk>> chunks(static_cast<size_t>(side) * side);
+
+		const auto getChunk = [&chunks, side, radius](const int x, const int z) -> std::shared_ptr<Chunk>& {
+			return chunks[(x + radius + 1) + (z + radius + 1) * side];
+		};
+
+		VoxelVolume& volume = ChunkPool::getScratchVolume();
+
+		for (int x = -radius - 1; x <= radius + 1; x++) {
+			for (int z = -radius - 1; z <= radius + 1; z++) {
+				Generation::generateAdvanced(seed, glm::ivec2(x, z), volume);
+				getChunk(x, z) = std::make_shared<Chunk>(volume);
+			}
+		}
+
+		MeshingResult result;
+
+		for (int x = -radius; x <= radius; x++) {
+			for (int z = -radius; z <= radius; z++) {
+				const ChunkNeighbors neighbors = { getChunk(x + 1, z), getChunk(x - 1, z), getChunk(x, z + 1), getChunk(x, z - 1) };
+				ChunkMesh mesh;
+
+				const Clock::time_point meshStart = Clock::now();
+				mesh.build(getChunk(x, z), neighbors);
+				result.meshTime += Clock::now() - meshStart;
+
+				result.faces += mesh.getBuiltFaceCount();
+				result.unmergedFaces += mesh.getBuiltUnmergedFaceCount();
+				result.chunkCount++;
+			}
+		}
+
+		if (result.chunkCount > 0) {
+			result.meshTime /= result.chunkCount;
+		}
+
+		return result;
+	}
+}
\ No newline at end of file
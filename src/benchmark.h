@@ -0,0 +1,32 @@
+#pragma once
+
+#include "simd.h"
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace Benchmark {
+	// Average time per chunk of each kernel at one SIMD level
+	struct SimdResult {
+		Simd::Level level = Simd::Level::Scalar;
+		std::chrono::nanoseconds maskTime = std::chrono::nanoseconds(0);
+		std::chrono::nanoseconds terrainTime = std::chrono::nanoseconds(0);
+	};
+
+	// Mask building on a chunk where every row mixes all voxel types, and terrain filling with heights spread over
+	// the whole column (water, beach and land), once per level the CPU supports (scalar is the original per voxel code)
+	std::vector<SimdResult> runSimd(const int iterations = 64);
+
+	// Greedy meshing totals over a block of chunks, every face is an instanced quad of 4 vertices
+	struct MeshingResult {
+		int chunkCount = 0;
+		size_t faces = 0;
+		size_t unmergedFaces = 0;
+		std::chrono::nanoseconds meshTime = std::chrono::nanoseconds(0);
+	};
+
+	// Meshes the chunks within radius of the origin on the Advanced generator, each with all four neighbors
+	// generated so only real surfaces count, and compares merged quads to one face per exposed voxel side
+	MeshingResult runMeshing(const uint32_t seed = 0, const int radius = 1);
+}
\ No newline at end of file
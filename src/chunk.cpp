@@ -1,8 +1,125 @@
 #include "chunk.h"
+#include <algorithm>
 #include <tracy/Tracy.hpp>
 
-Chunk::Chunk(VoxelVolume&& data) : voxels(std::move(data.voxels)) {
+namespace {
+	static_assert(sizeof(Voxel) == 1, "Mask kernels read voxels as bytes");
+	static_assert(CHUNK_SIZE == 32, "Mask kernels classify a row per 32 byte load");
+	static_assert(static_cast<size_t>(VoxelType::COUNT) <= 16, "Mask kernels look types up in a 16 entry shuffle table");
+
+	// High bit set for types in the mask, what movemask collects
+	template <bool Liquid>
+	constexpr std::array<uint8_t, 16> makeTypeTable() {
+		std::array<uint8_t, 16> table = {};
+		for (size_t type = 0; type < static_cast<size_t>(VoxelType::COUNT); type++) {
+			const bool inMask = Liquid ? static_cast<VoxelType>(type) == VoxelType::WATER : Chunk::isOpaque(static_cast<VoxelType>(type));
+			table[type] = inMask ? 0xFF : 0x00;
+		}
+		return table;
+	}
+
+	alignas(16) constexpr std::array<uint8_t, 16> OPAQUE_TABLE = makeTypeTable<false>();
+	alignas(16) constexpr std::array<uint8_t, 16> LIQUID_TABLE = makeTypeTable<true>();
+
+	// Start of a mask row (y * CHUNK_SIZE + z) in the x-fastest volume
+	const Voxel* getRowVoxels(const VoxelVolume& data, const int row) {
+		return &data.voxels[(row / CHUNK_SIZE) * CHUNK_SIZE + (row % CHUNK_SIZE) * CHUNK_SIZE * MAX_HEIGHT];
+	}
+
+	void classifyRowsScalar(const VoxelVolume& data, const int firstRow, const int rowCount, Masks& masks) {
+		for (int row = firstRow; row < firstRow + rowCount; row++) {
+			const Voxel* voxels = getRowVoxels(data, row);
+
+			uint32_t maskOpaque = 0;
+			uint32_t maskWater = 0;
+
+			for (int x = 0; x < CHUNK_SIZE; x++) {
+				maskOpaque |= uint32_t(Chunk::isOpaque(voxels[x].type)) << x;
+				maskWater |= uint32_t(voxels[x].type == VoxelType::WATER) << x;
+			}
+
+			masks.opaque[row] = maskOpaque;
+			masks.liquid[row] = maskWater;
+		}
+	}
+
+#if SIMD_X86
+	// Two 16 voxel halves, shuffle looks each type up and movemask packs the bits
+	SIMD_TARGET_SSE41 void classifyRowsSSE41(const VoxelVolume& data, const int firstRow, const int rowCount, Masks& masks) {
+		const __m128i opaqueTable = _mm_load_si128(reinterpret_cast<const __m128i*>(OPAQUE_TABLE.data()));
+		const __m128i liquidTable = _mm_load_si128(reinterpret_cast<const __m128i*>(LIQUID_TABLE.data()));
+
+		for (int row = firstRow; row < firstRow + rowCount; row++) {
+			const __m128i* voxels = reinterpret_cast<const __m128i*>(getRowVoxels(data, row));
+			const __m128i low = _mm_loadu_si128(voxels);
+			const __m128i high = _mm_loadu_si128(voxels + 1);
+
+			const uint32_t maskOpaque = uint32_t(_mm_movemask_epi8(_mm_shuffle_epi8(opaqueTable, low))) | (uint32_t(_mm_movemask_epi8(_mm_shuffle_epi8(opaqueTable, high))) << 16);
+			const uint32_t maskWater = uint32_t(_mm_movemask_epi8(_mm_shuffle_epi8(liquidTable, low))) | (uint32_t(_mm_movemask_epi8(_mm_shuffle_epi8(liquidTable, high))) << 16);
+
+			masks.opaque[row] = maskOpaque;
+			masks.liquid[row] = maskWater;
+		}
+	}
+
+	// Whole row per load, the table is repeated in both lanes since the shuffle works per 128 bits
+	SIMD_TARGET_AVX2 void classifyRowsAVX2(const VoxelVolume& data, const int firstRow, const int rowCount, Masks& masks) {
+		const __m256i opaqueTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(OPAQUE_TABLE.data())));
+		const __m256i liquidTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(LIQUID_TABLE.data())));
+
+		for (int row = firstRow; row < firstRow + rowCount; row++) {
+			const __m256i voxels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(getRowVoxels(data, row)));
+
+			const uint32_t maskOpaque = uint32_t(_mm256_movemask_epi8(_mm256_shuffle_epi8(opaqueTable, voxels)));
+			const uint32_t maskWater = uint32_t(_mm256_movemask_epi8(_mm256_shuffle_epi8(liquidTable, voxels)));
+
+			masks.opaque[row] = maskOpaque;
+			masks.liquid[row] = maskWater;
+		}
+	}
+#endif
+}
+
+Chunk::Chunk(const VoxelVolume& data) {
+	load(data);
+}
+
+// Replaces the contents, reusing section storage where the new data fits
+void Chunk::load(const VoxelVolume& data) {
+	ZoneScopedN("Pack Chunk Sections");
+	std::unique_lock lock(voxelsMutex);
+
+	// Sections pack straight out of the full height volume
+	for (int section = 0; section < SECTION_COUNT; section++) {
+		sections[section].assign(&data.voxels[section * SECTION_HEIGHT * CHUNK_SIZE], CHUNK_SIZE * MAX_HEIGHT);
+	}
+
+	// Occupancy masks, uniform sections fill whole rows without reading voxels
+	for (int section = 0; section < SECTION_COUNT; section++) {
+		const int rowOffset = section * SECTION_HEIGHT * CHUNK_SIZE;
+
+		if (sections[section].getFill() != SectionFill::Mixed) {
+			setMaskRows(rowOffset, SECTION_HEIGHT * CHUNK_SIZE, sections[section].getUniformType());
+			continue;
+		}
+
+		classifyRows(data, rowOffset, SECTION_HEIGHT * CHUNK_SIZE, masks);
+	}
+
+	// Border slabs read straight from the volume too, it's cheaper than decoding sections
+	borders.fill(BorderSlab());
+
+	for (int y = 0; y < MAX_HEIGHT; y++) {
+		for (int i = 0; i < CHUNK_SIZE; i++) {
+			setBorderVoxel(glm::ivec3(CHUNK_SIZE - 1, y, i), data.voxels[(CHUNK_SIZE - 1) + y * CHUNK_SIZE + i * CHUNK_SIZE * MAX_HEIGHT].type);
+			setBorderVoxel(glm::ivec3(0, y, i), data.voxels[y * CHUNK_SIZE + i * CHUNK_SIZE * MAX_HEIGHT].type);
+			setBorderVoxel(glm::ivec3(i, y, CHUNK_SIZE - 1), data.voxels[i + y * CHUNK_SIZE + (CHUNK_SIZE - 1) * CHUNK_SIZE * MAX_HEIGHT].type);
+			setBorderVoxel(glm::ivec3(i, y, 0), data.voxels[i + y * CHUNK_SIZE].type);
+		}
+	}
+
 	voxelCount.store(data.voxelCount);
+	dirtySections.store(0);
 }
 
 bool Chunk::hasVoxel(const glm::ivec3& chunkPosition, bool ignoreLiquid) const {
@@ -12,7 +129,7 @@ bool Chunk::hasVoxel(const glm::ivec3& chunkPosition, bool ignoreLiquid) const {
 
 	std::shared_lock lock(voxelsMutex);
 
-	const VoxelType type = voxels[getVoxelIndex(chunkPosition)].type;
+	const VoxelType type = getType(chunkPosition);
 	return type != VoxelType::EMPTY && (!ignoreLiquid || !VoxelTypeData[static_cast<uint8_t>(type)].isLiquid);
 }
 
@@ -22,101 +139,205 @@ VoxelType Chunk::getVoxelType(const glm::ivec3& position) const {
 	}
 	std::shared_lock lock(voxelsMutex);
 
-	return voxels[getVoxelIndex(position)].type;
+	return getType(position);
 }
 
-void Chunk::setVoxelType(const glm::ivec3& chunkPosition, const VoxelType type) {
-	if (!isValidPosition(chunkPosition)) {
-		return;
-	}
+// Returns whether the voxel changed
+bool Chunk::setVoxelType(const glm::ivec3& chunkPosition, const VoxelType type) {
+	const VoxelEdit edit = { chunkPosition, type };
+	return setVoxelTypes(std::span<const VoxelEdit>(&edit, 1)).changed > 0;
+}
+
+// Applies edits in chunk space under a single lock, invalid positions are skipped
+ChunkEditResult Chunk::setVoxelTypes(const std::span<const VoxelEdit> edits) {
+	ChunkEditResult result;
+	uint32_t sectionMask = 0;
+
 	std::unique_lock lock(voxelsMutex);
 
-	Voxel& voxel = voxels[getVoxelIndex(chunkPosition)];
+	for (const VoxelEdit& edit : edits) {
+		const glm::ivec3& chunkPosition = edit.position;
+		if (!isValidPosition(chunkPosition)) {
+			continue;
+		}
 
-	if (voxel.type == type) {
-		return;
-	}
+		const VoxelType current = getType(chunkPosition);
+		if (current == edit.type) {
+			continue;
+		}
 
-	if (type == VoxelType::EMPTY) {
-		voxelCount--;
-	}
-	else if (voxel.type == VoxelType::EMPTY) {
-		voxelCount++;
+		if (edit.type == VoxelType::EMPTY) {
+			voxelCount--;
+		}
+		else if (current == VoxelType::EMPTY) {
+			voxelCount++;
+		}
+
+		sections[chunkPosition.y / SECTION_HEIGHT].set(ChunkSection::getIndex(chunkPosition.x, chunkPosition.y % SECTION_HEIGHT, chunkPosition.z), edit.type);
+		setMaskVoxel(chunkPosition, edit.type);
+		setBorderVoxel(chunkPosition, edit.type);
+
+		// Faces on a section boundary belong to the voxels on either side
+		const int section = chunkPosition.y / SECTION_HEIGHT;
+		const int sectionY = chunkPosition.y % SECTION_HEIGHT;
+
+		sectionMask |= 1u << section;
+		if (sectionY == 0 && section > 0) {
+			sectionMask |= 1u << (section - 1);
+		}
+		if (sectionY == SECTION_HEIGHT - 1 && section < SECTION_COUNT - 1) {
+			sectionMask |= 1u << (section + 1);
+		}
+
+		// Neighbors only see border voxels, in their own section at the same height
+		const uint32_t borderSection = 1u << section;
+		if (chunkPosition.x == CHUNK_SIZE - 1) {
+			result.borderSections[static_cast<size_t>(Direction2D::PX)] |= borderSection;
+		}
+		if (chunkPosition.x == 0) {
+			result.borderSections[static_cast<size_t>(Direction2D::NX)] |= borderSection;
+		}
+		if (chunkPosition.z == CHUNK_SIZE - 1) {
+			result.borderSections[static_cast<size_t>(Direction2D::PZ)] |= borderSection;
+		}
+		if (chunkPosition.z == 0) {
+			result.borderSections[static_cast<size_t>(Direction2D::NZ)] |= borderSection;
+		}
+
+		result.changed++;
 	}
 
-	voxel.type = type;
-	dirty.store(true);
+	dirtySections.fetch_or(sectionMask);
+	return result;
 }
 
 void Chunk::clearVoxels() {
 	std::unique_lock lock(voxelsMutex);
 
-	for (int i = 0; i < MAX_VOXELS; i++) {
-		voxels[i].type = VoxelType::EMPTY;
+	for (ChunkSection& section : sections) {
+		section.fill(VoxelType::EMPTY);
 	}
 
+	setMaskRows(0, CHUNK_SIZE * MAX_HEIGHT, VoxelType::EMPTY);
+	borders.fill(BorderSlab());
+
 	voxelCount.store(0);
-	dirty.store(true);
+	dirtySections.store(ALL_SECTIONS);
 }
 
-void Chunk::getMasks(Masks& masks) const {
-	ZoneScopedN("Build Occupancy Masks");
+SectionFill Chunk::getSectionFill(const int section) const {
 	std::shared_lock lock(voxelsMutex);
+	return sections[section].getFill();
+}
 
-	masks.opaque.fill(0);
-	masks.liquid.fill(0);
-	masks.filled.fill(0);
+// Type filling a uniform section (meaningless for mixed ones)
+VoxelType Chunk::getSectionType(const int section) const {
+	std::shared_lock lock(voxelsMutex);
+	return sections[section].getUniformType();
+}
 
-	for (int y = 0; y < MAX_HEIGHT; y++) {
-		for (int z = 0; z < CHUNK_SIZE; z++) {
-			uint32_t maskOpaque = 0;
-			uint32_t maskWater = 0;
-			uint32_t maskTranslucent = 0;
+// Builds mask rows from a volume, row is y * CHUNK_SIZE + z like the masks themselves
+void Chunk::classifyRows(const VoxelVolume& data, const int firstRow, const int rowCount, Masks& masks, const Simd::Level level) {
+#if SIMD_X86
+	if (level >= Simd::Level::AVX2) {
+		classifyRowsAVX2(data, firstRow, rowCount, masks);
+		return;
+	}
 
-			for (int x = 0; x < CHUNK_SIZE; x++) {
-				const int index = x + y * CHUNK_SIZE + z * CHUNK_SIZE * MAX_HEIGHT;
-				const VoxelType type = voxels[index].type;
-
-				switch (type) {
-				case VoxelType::EMPTY:
-					break;
-				case VoxelType::WATER:
-					maskWater |= (1u << x);
-					break;
-				default: {
-					const uint8_t typeIndex = static_cast<uint8_t>(type);
-
-					// Opaque
-					if (VoxelTypeData[typeIndex].color.a == 255) {
-						maskOpaque |= (1u << x);
-					}
-					// Translucent
-					else {
-						maskTranslucent |= (1u << x);
-					}
-				}
+	if (level >= Simd::Level::SSE41) {
+		classifyRowsSSE41(data, firstRow, rowCount, masks);
+		return;
+	}
+#endif
+
+	classifyRowsScalar(data, firstRow, rowCount, masks);
+}
+
+// Types are only decoded for sections in the mask, masks are always copied whole
+void Chunk::getSnapshot(ChunkSnapshot& snapshot, const uint32_t sectionMask) const {
+	ZoneScopedN("Snapshot Chunk");
+	std::shared_lock lock(voxelsMutex);
+
+	// Masks are kept current, only types need decoding (and filled is derived, it isn't worth keeping per chunk)
+	snapshot.masks = masks;
+
+	for (size_t row = 0; row < snapshot.filled.size(); row++) {
+		snapshot.filled[row] = masks.opaque[row] | masks.liquid[row];
+	}
+
+	for (int sectionIndex = 0; sectionIndex < SECTION_COUNT; sectionIndex++) {
+		if ((sectionMask & (1u << sectionIndex)) == 0) {
+			continue;
+		}
+
+		const ChunkSection& section = sections[sectionIndex];
+		const int rowOffset = sectionIndex * SECTION_HEIGHT * CHUNK_SIZE;
+
+		if (section.isUniform()) {
+			std::fill_n(snapshot.types.begin() + rowOffset * CHUNK_SIZE, SECTION_VOXELS, section.getUniformType());
+			continue;
+		}
+
+		for (int y = 0; y < SECTION_HEIGHT; y++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				VoxelType* types = &snapshot.types[(rowOffset + y * CHUNK_SIZE + z) * CHUNK_SIZE];
+
+				for (int x = 0; x < CHUNK_SIZE; x++) {
+					types[x] = section.getPaletteEntry(section.getPaletteIndex(ChunkSection::getIndex(x, y, z)));
 				}
 			}
-
-			masks.opaque[y * CHUNK_SIZE + z] = maskOpaque;
-			masks.liquid[y * CHUNK_SIZE + z] = maskWater;
-			masks.filled[y * CHUNK_SIZE + z] = maskOpaque | maskWater;
 		}
 	}
 }
 
-uint32_t Chunk::getMask(const int y, const int z, bool liquid) const {
+// Sets count rows from the first to the masks of a single type
+void Chunk::setMaskRows(const int firstRow, const int count, const VoxelType type) {
+	const uint32_t maskOpaque = isOpaque(type) ? ~0u : 0u;
+	const uint32_t maskWater = type == VoxelType::WATER ? ~0u : 0u;
+
+	std::fill_n(masks.opaque.begin() + firstRow, count, maskOpaque);
+	std::fill_n(masks.liquid.begin() + firstRow, count, maskWater);
+}
+
+void Chunk::setMaskVoxel(const glm::ivec3& chunkPosition, const VoxelType type) {
+	const int row = chunkPosition.y * CHUNK_SIZE + chunkPosition.z;
+	const uint32_t bit = 1u << chunkPosition.x;
+
+	const uint32_t opaqueBit = isOpaque(type) ? bit : 0u;
+	const uint32_t waterBit = type == VoxelType::WATER ? bit : 0u;
+
+	masks.opaque[row] = (masks.opaque[row] & ~bit) | opaqueBit;
+	masks.liquid[row] = (masks.liquid[row] & ~bit) | waterBit;
+}
+
+void Chunk::getBorder(const Direction2D side, BorderSlab& border) const {
 	std::shared_lock lock(voxelsMutex);
+	border = borders[static_cast<size_t>(side)];
+}
 
-	uint32_t mask = 0;
+// Updates every border slab the position lies on (corners are on two)
+void Chunk::setBorderVoxel(const glm::ivec3& chunkPosition, const VoxelType type) {
+	if (chunkPosition.x == CHUNK_SIZE - 1) {
+		setBorderBit(borders[static_cast<size_t>(Direction2D::PX)], chunkPosition.y, chunkPosition.z, type);
+	}
+	if (chunkPosition.x == 0) {
+		setBorderBit(borders[static_cast<size_t>(Direction2D::NX)], chunkPosition.y, chunkPosition.z, type);
+	}
+	if (chunkPosition.z == CHUNK_SIZE - 1) {
+		setBorderBit(borders[static_cast<size_t>(Direction2D::PZ)], chunkPosition.y, chunkPosition.x, type);
+	}
+	if (chunkPosition.z == 0) {
+		setBorderBit(borders[static_cast<size_t>(Direction2D::NZ)], chunkPosition.y, chunkPosition.x, type);
+	}
+}
 
-	for (int x = 0; x < CHUNK_SIZE; x++) {
-		const VoxelType type = voxels[getVoxelIndex(glm::ivec3(x, y, z))].type;
+size_t Chunk::getMemoryUsage() const {
+	std::shared_lock lock(voxelsMutex);
 
-		if (liquid ? (type != VoxelType::EMPTY) : VoxelTypeData[static_cast<uint8_t>(type)].color.a == 255) {
-			mask |= (1u << x);
-		}
+	size_t bytes = sizeof(Chunk) - sizeof(sections);
+	for (const ChunkSection& section : sections) {
+		bytes += section.getMemoryUsage();
 	}
 
-	return mask;
-}
+	return bytes;
+}
\ No newline at end of file
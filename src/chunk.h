@@ -2,41 +2,87 @@
 
 #include "structs.h"
 #include "generation.h"
+#include "chunkSection.h"
+#include "simd.h"
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <array>
+#include <span>
 #include <atomic>
 #include <shared_mutex>
 #include <mutex>
 
+// Voxel bits on one vertical border face, a word per y with bits along z (X borders) or x (Z borders)
+struct BorderSlab {
+	std::array<uint32_t, MAX_HEIGHT> opaque = {};
+	std::array<uint32_t, MAX_HEIGHT> filled = {};
+};
+
+// What a batch of edits changed, border sections (Direction2D order) are the neighbor sections that see the changes
+struct ChunkEditResult {
+	int changed = 0;
+	std::array<uint32_t, static_cast<size_t>(Direction2D::COUNT)> borderSections = {};
+};
+
 class Chunk {
 public:
-	Chunk(VoxelVolume&& data);
+	Chunk(const VoxelVolume& data);
+
+	void load(const VoxelVolume& data);
   
 	bool hasVoxel(const glm::ivec3& chunkPosition, bool ignoreLiquid = false) const;
 	VoxelType getVoxelType(const glm::ivec3& chunkPosition) const;
-	void setVoxelType(const glm::ivec3& chunkPosition, const VoxelType type = VoxelType::STONE);
+	bool setVoxelType(const glm::ivec3& chunkPosition, const VoxelType type = VoxelType::STONE);
+	ChunkEditResult setVoxelTypes(const std::span<const VoxelEdit> edits);
 	void clearVoxels();
 
-	void getMasks(Masks& masks) const;
-	uint32_t getMask(const int y, const int z, bool liquid) const;
+	void getSnapshot(ChunkSnapshot& snapshot, const uint32_t sectionMask = ALL_SECTIONS) const;
+	void getBorder(const Direction2D side, BorderSlab& border) const;
+
+	SectionFill getSectionFill(const int section) const;
+	VoxelType getSectionType(const int section) const;
+
+	static constexpr bool isOpaque(const VoxelType type) {
+		return VoxelTypeData[static_cast<uint8_t>(type)].color.a == 255;
+	}
+
+	static void classifyRows(const VoxelVolume& data, const int firstRow, const int rowCount, Masks& masks, const Simd::Level level = Simd::getLevel());
 
 	int getVoxelCount() const { return voxelCount.load(); }
-	bool isDirty() const { return dirty.load(); }
-	void clearDirty() { dirty.store(false); }
+	size_t getMemoryUsage() const;
+	// Sections whose faces an edit may have changed since the last take
+	bool isDirty() const { return dirtySections.load() != 0; }
+	uint32_t takeDirtySections() { return dirtySections.exchange(0); }
+	void markSectionsDirty(const uint32_t sectionMask) { dirtySections.fetch_or(sectionMask); }
 
 private:
-	std::array<Voxel, MAX_VOXELS> voxels;
+	std::array<ChunkSection, SECTION_COUNT> sections;
 	mutable std::shared_mutex voxelsMutex;
 
+	// Occupancy masks, built on load and patched bit by bit on edits (guarded by the voxel mutex)
+	Masks masks;
+
+	// Border faces in Direction2D order, kept current on every edit (guarded by the voxel mutex)
+	std::array<BorderSlab, static_cast<size_t>(Direction2D::COUNT)> borders;
+
 	std::atomic<int> voxelCount = 0;
-	std::atomic<bool> dirty = false;
+	std::atomic<uint32_t> dirtySections = 0;
 
 	static bool isValidPosition(const glm::ivec3& chunkPosition) {
 		return (chunkPosition.x >= 0 && chunkPosition.x < CHUNK_SIZE && chunkPosition.y >= 0 && chunkPosition.y < MAX_HEIGHT && chunkPosition.z >= 0 && chunkPosition.z < CHUNK_SIZE);
 	};
 
-	int getVoxelIndex(const glm::ivec3& chunkPosition) const {
-		return chunkPosition.x + chunkPosition.y * CHUNK_SIZE + chunkPosition.z * CHUNK_SIZE * MAX_HEIGHT;
+	void setMaskRows(const int firstRow, const int count, const VoxelType type);
+	void setMaskVoxel(const glm::ivec3& chunkPosition, const VoxelType type);
+	void setBorderVoxel(const glm::ivec3& chunkPosition, const VoxelType type);
+
+	static void setBorderBit(BorderSlab& border, const int y, const int bit, const VoxelType type) {
+		const uint32_t mask = 1u << bit;
+		border.opaque[y] = isOpaque(type) ? (border.opaque[y] | mask) : (border.opaque[y] & ~mask);
+		border.filled[y] = type != VoxelType::EMPTY ? (border.filled[y] | mask) : (border.filled[y] & ~mask);
+	}
+
+	VoxelType getType(const glm::ivec3& chunkPosition) const {
+		return sections[chunkPosition.y / SECTION_HEIGHT].get(ChunkSection::getIndex(chunkPosition.x, chunkPosition.y % SECTION_HEIGHT, chunkPosition.z));
 	};
 };
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "chunkGrid.h"
+
+ChunkGrid::ChunkGrid(const int radius) : size(radius * 2 + 1), slots(std::make_unique<ChunkSlot[]>(static_cast<size_t>(size) * size)) {
+
+}
+
+// Returns the slot holding the chunk index (any state but empty), or null if the slot holds something else
+ChunkSlot* ChunkGrid::find(const glm::ivec2& chunkIndex) {
+	ChunkSlot& slot = slots[getSlotIndex(chunkIndex)];
+
+	if (slot.state.load() == ChunkState::Empty || slot.key.load() != packKey(chunkIndex)) {
+		return nullptr;
+	}
+
+	return &slot;
+}
+
+// Returns the generated chunk at the chunk index without locking, null if missing or the slot changed mid-read
+std::shared_ptr<Chunk> ChunkGrid::getChunk(const glm::ivec2& chunkIndex) {
+	ChunkSlot& slot = slots[getSlotIndex(chunkIndex)];
+
+	const uint32_t generation = slot.generation.load();
+	if ((generation & 1u) != 0) {
+		return nullptr;
+	}
+
+	if (slot.key.load() != packKey(chunkIndex) || !slot.hasChunk()) {
+		return nullptr;
+	}
+
+	std::shared_ptr<Chunk> chunk = slot.chunk.load();
+
+	if (slot.generation.load() != generation) {
+		return nullptr;
+	}
+
+	return chunk;
+}
+
+// Assigns the slot for the chunk index to it, evicting whatever was there (main thread only)
+// Whatever chunk was pushed out is reported, so its neighbors can be unlinked
+ChunkSlot& ChunkGrid::claim(const glm::ivec2& chunkIndex, uint32_t& generation, std::optional<glm::ivec2>& evictedIndex) {
+	ChunkSlot& slot = slots[getSlotIndex(chunkIndex)];
+	std::lock_guard<std::mutex> lock(slot.mutex);
+
+	evictedIndex.reset();
+
+	if (slot.state.load() != ChunkState::Empty) {
+		evictedIndex = unpackKey(slot.key.load());
+		clearSlot(slot);
+	}
+
+	slot.generation++;
+	slot.key.store(packKey(chunkIndex));
+	slot.chunk.store(nullptr);
+	slot.mesh.store(std::make_shared<ChunkMesh>());
+	slot.neighborMask.store(0);
+	slot.lastUsedFrame.store(0);
+	slot.stateBeforeMeshing.store(ChunkState::Generated);
+	slot.state.store(ChunkState::Requested);
+	slot.generation++;
+
+	generation = slot.generation.load();
+	return slot;
+}
+
+void ChunkGrid::evict(ChunkSlot& slot) {
+	std::lock_guard<std::mutex> lock(slot.mutex);
+
+	if (slot.state.load() != ChunkState::Empty) {
+		clearSlot(slot);
+	}
+}
+
+// Moves the slot between states, fails if it was reassigned since the generation was read
+bool ChunkGrid::transition(ChunkSlot& slot, const uint32_t generation, const ChunkState from, const ChunkState to) {
+	std::lock_guard<std::mutex> lock(slot.mutex);
+
+	if (slot.generation.load() != generation) {
+		return false;
+	}
+
+	ChunkState expected = from;
+	return slot.state.compare_exchange_strong(expected, to);
+}
+
+bool ChunkGrid::publishChunk(ChunkSlot& slot, const uint32_t generation, std::shared_ptr<Chunk> chunk) {
+	std::lock_guard<std::mutex> lock(slot.mutex);
+
+	if (slot.generation.load() != generation || slot.state.load() != ChunkState::Generating) {
+		return false;
+	}
+
+	// Edits don't update this, it's an estimate for the memory budget
+	const size_t bytes = chunk->getMemoryUsage();
+	slot.chunkBytes.store(bytes);
+	residentBytes += bytes;
+
+	slot.chunk.store(std::move(chunk));
+	slot.state.store(ChunkState::Generated);
+	loadedCount++;
+
+	return true;
+}
+
+// Gives up a request so the chunk index can be claimed again later
+void ChunkGrid::release(ChunkSlot& slot, const uint32_t generation) {
+	std::lock_guard<std::mutex> lock(slot.mutex);
+
+	if (slot.generation.load() == generation) {
+		clearSlot(slot);
+	}
+}
+
+void ChunkGrid::setMeshBytes(ChunkSlot& slot, const uint32_t generation, const size_t bytes) {
+	std::lock_guard<std::mutex> lock(slot.mutex);
+
+	if (slot.generation.load() != generation) {
+		return;
+	}
+
+	residentBytes += bytes;
+	residentBytes -= slot.meshBytes.exchange(bytes);
+}
+
+// Sets the neighbor bits of two adjacent chunks for each other (direction is from the slot to the neighbor)
+// Both mutexes are held so neither slot can be reassigned in between, fails if the slot moved past its generation
+// or the neighbor slot no longer holds a generated chunk at the neighbor index
+bool ChunkGrid::linkNeighbor(ChunkSlot& slot, const uint32_t generation, const int direction, const glm::ivec2& neighborIndex, uint32_t& neighborGeneration, uint8_t& neighborPreviousMask) {
+	ChunkSlot& neighbor = slots[getSlotIndex(neighborIndex)];
+	std::scoped_lock lock(slot.mutex, neighbor.mutex);
+
+	if (slot.generation.load() != generation || neighbor.key.load() != packKey(neighborIndex) || !neighbor.hasChunk()) {
+		return false;
+	}
+
+	// Opposite direction is the adjacent bit (PX/NX, PZ/NZ)
+	slot.neighborMask.fetch_or(uint8_t(1u << direction));
+	neighborPreviousMask = neighbor.neighborMask.fetch_or(uint8_t(1u << (direction ^ 1)));
+	neighborGeneration = neighbor.generation.load();
+
+	return true;
+}
+
+// Expects the slot mutex to be held
+void ChunkGrid::clearSlot(ChunkSlot& slot) {
+	slot.generation++;
+
+	// In-flight jobs see Evicting (then a new generation) and drop their results
+	if (slot.hasChunk()) {
+		loadedCount--;
+	}
+	slot.state.store(ChunkState::Evicting);
+
+	residentBytes -= slot.chunkBytes.exchange(0) + slot.meshBytes.exchange(0);
+
+	slot.chunk.store(nullptr);
+	slot.mesh.store(nullptr);
+	slot.neighborMask.store(0);
+	slot.state.store(ChunkState::Empty);
+
+	slot.generation++;
+}
\ No newline at end of file
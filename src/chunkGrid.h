@@ -0,0 +1,103 @@
+#pragma once
+
+#include "chunk.h"
+#include "chunkMesh.h"
+#include <glm/vec2.hpp>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+// Lifecycle of a chunk slot, transitions are CAS'd so each stage runs once
+enum class ChunkState : uint8_t {
+	Empty,
+	Requested,
+	Generating,
+	Generated,
+	Meshing,
+	Meshed,
+	Uploaded,
+	Evicting,
+};
+
+struct ChunkSlot {
+	std::atomic<ChunkState> state = ChunkState::Empty;
+
+	// State the slot left for Meshing, restored if the job is cancelled so an uploaded mesh keeps drawing
+	std::atomic<ChunkState> stateBeforeMeshing = ChunkState::Generated;
+
+	// Bumped to odd while the slot is being reassigned, back to even once stable
+	std::atomic<uint32_t> generation = 0;
+	std::atomic<uint64_t> key = 0;
+
+	std::atomic<std::shared_ptr<Chunk>> chunk;
+	std::atomic<std::shared_ptr<ChunkMesh>> mesh;
+
+	// Frame the chunk was last inside the render distance, for LRU eviction
+	std::atomic<uint64_t> lastUsedFrame = 0;
+
+	// Voxel and GPU mesh bytes counted against the memory budget
+	std::atomic<size_t> chunkBytes = 0;
+	std::atomic<size_t> meshBytes = 0;
+
+	// One bit per generated neighbor (DirectionVectors2D order), meshable once all four are set
+	std::atomic<uint8_t> neighborMask = 0;
+	static constexpr uint8_t ALL_NEIGHBORS = 0b1111;
+
+	// Taken by every write (claim, evict and each state transition), only find and getChunk read without it
+	std::mutex mutex;
+
+	bool hasChunk() const {
+		const ChunkState current = state.load();
+		return current >= ChunkState::Generated && current <= ChunkState::Uploaded;
+	}
+};
+
+// Toroidal grid of chunk slots, indexed by chunk index modulo the grid size
+class ChunkGrid {
+public:
+	// Holds every chunk within radius of the center without two sharing a slot
+	ChunkGrid(const int radius);
+
+	ChunkSlot* find(const glm::ivec2& chunkIndex);
+	std::shared_ptr<Chunk> getChunk(const glm::ivec2& chunkIndex);
+
+	ChunkSlot& claim(const glm::ivec2& chunkIndex, uint32_t& generation, std::optional<glm::ivec2>& evictedIndex);
+	void evict(ChunkSlot& slot);
+
+	bool transition(ChunkSlot& slot, const uint32_t generation, const ChunkState from, const ChunkState to);
+	bool publishChunk(ChunkSlot& slot, const uint32_t generation, std::shared_ptr<Chunk> chunk);
+	void release(ChunkSlot& slot, const uint32_t generation);
+	void setMeshBytes(ChunkSlot& slot, const uint32_t generation, const size_t bytes);
+	bool linkNeighbor(ChunkSlot& slot, const uint32_t generation, const int direction, const glm::ivec2& neighborIndex, uint32_t& neighborGeneration, uint8_t& neighborPreviousMask);
+
+	int getSize() const { return size; }
+	int getCapacity() const { return size * size; }
+	int getLoadedCount() const { return loadedCount.load(); }
+	size_t getResidentBytes() const { return residentBytes.load(); }
+
+	ChunkSlot& getSlotAt(const int slotIndex) { return slots[slotIndex]; }
+	glm::ivec2 getSlotChunkIndex(const ChunkSlot& slot) const { return unpackKey(slot.key.load()); }
+
+	static uint64_t packKey(const glm::ivec2& chunkIndex) {
+		return (static_cast<uint64_t>(static_cast<uint32_t>(chunkIndex.x)) << 32) | static_cast<uint32_t>(chunkIndex.y);
+	}
+
+	static glm::ivec2 unpackKey(const uint64_t key) {
+		return glm::ivec2(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFFu));
+	}
+
+private:
+	int size;
+	std::unique_ptr<ChunkSlot[]> slots;
+	std::atomic<int> loadedCount = 0;
+	std::atomic<size_t> residentBytes = 0;
+
+	int getSlotIndex(const glm::ivec2& chunkIndex) const {
+		const int x = ((chunkIndex.x % size) + size) % size;
+		const int z = ((chunkIndex.y % size) + size) % size;
+		return x + z * size;
+	}
+
+	void clearSlot(ChunkSlot& slot);
+};
\ No newline at end of file
@@ -2,22 +2,30 @@
 #include "shader.h"
 #include <tracy/Tracy.hpp>
 #include <stdexcept>
-#include <iostream>
 #include <array>
 #include <chrono>
 #include <thread>
 #include <ranges>
 #include <vector>
 #include <bit>
+#include <algorithm>
 
-void ChunkMesh::update() {
+void ChunkMesh::update(FacePool& pool) {
 	// Upload mesh if ready
 	if (meshStateOpaque.load() == MeshState::HANDOFF) {
 		ZoneScopedN("Mesh Upload Opaque");
 
-		// Create new mesh
+		// Patch the existing mesh from the first changed face, or create it
 		std::lock_guard<std::mutex> lock(faceMutexOpaque);
-		meshOpaque = std::make_unique<Mesh>(std::move(facesOpaque));
+		uploadFaces(pool, meshOpaque, facesOpaque, pendingFirstFaceOpaque);
+
+		minY = pendingMinY;
+		maxY = pendingMaxY;
+		sectionMinY = sectionMinFaceY;
+		sectionMaxY = sectionMaxFaceY;
+		unmergedFaceCount = pendingUnmergedFaceCount;
+		faceCount = pendingFaceCount;
+		occluderHeights = pendingOccluderHeights;
 
 		meshStateOpaque.store(MeshState::READY);
 	}
@@ -26,185 +34,428 @@ void ChunkMesh::update() {
 	if (meshStateLiquid.load() == MeshState::HANDOFF) {
 		ZoneScopedN("Mesh Upload Liquid");
 
-		// Create new mesh
+		// Patch the existing mesh from the first changed face, or create it
 		std::lock_guard<std::mutex> lock(faceMutexLiquid);
-		meshLiquid = std::make_unique<Mesh>(std::move(facesLiquid));
+		uploadFaces(pool, meshLiquid, facesLiquid, pendingFirstFaceLiquid);
 
 		meshStateLiquid.store(MeshState::READY);
 	}
 }
 
-void ChunkMesh::drawOpaque(const glm::ivec2 offset, const glm::mat4& view, const glm::mat4& projection, Shader& shader) {
-	ZoneScopedN("Chunk Draw Opaque");
-
-	if (meshOpaque) {
-		meshOpaque->draw(glm::vec3(offset.x, 0.0f, offset.y), view, projection, shader);
+void ChunkMesh::uploadFaces(FacePool& pool, std::unique_ptr<Mesh>& mesh, std::vector<Face>& faces, size_t& firstFace) {
+	if (mesh) {
+		mesh->update(faces, firstFace);
 	}
-}
-
-void ChunkMesh::drawWater(const glm::ivec2 offset, const glm::mat4& view, const glm::mat4& projection, Shader& shader) {
-	ZoneScopedN("Chunk Draw Water");
-
-	if (meshLiquid) {
-		meshLiquid->draw(glm::vec3(offset.x, 0.0f, offset.y), view, projection, shader);
+	else {
+		mesh = std::make_unique<Mesh>(pool, std::move(faces));
 	}
+
+	// Sections keep their own copies, the flattened list is only needed for the upload
+	faces = std::vector<Face>();
+	firstFace = NO_PENDING_FACES;
 }
 
-void ChunkMesh::build(const std::shared_ptr<Chunk> chunk, const ChunkNeighbors& neighbors) {
+void ChunkMesh::build(const std::shared_ptr<Chunk> chunk, const ChunkNeighbors& neighbors, const uint32_t dirtySections) {
 	ZoneScopedN("Start Mask Meshing");
 
-	// Handle empty chunk
-	if (chunk->getVoxelCount() <= 0) {
-		std::cout << "Chunk is empty, meshing skipped" << std::endl;
+	// Empty chunks go through the same path, every section skips and an empty mesh replaces whatever was there
+	std::lock_guard<std::mutex> lock1(faceMutexOpaque);
+	std::lock_guard<std::mutex> lock2(faceMutexLiquid);
+
+	// The first build covers every section, later ones only what edits touched
+	const uint32_t sections = built ? (dirtySections & ALL_SECTIONS) : ALL_SECTIONS;
+	if (sections == 0) {
 		return;
 	}
 
 	meshStateOpaque.store(MeshState::BUILDING);
 	meshStateLiquid.store(MeshState::BUILDING);
 
-	// Clear faces
-	std::lock_guard<std::mutex> lock1(faceMutexOpaque);
-	facesOpaque.clear();
-	std::lock_guard<std::mutex> lock2(faceMutexLiquid);
-	facesLiquid.clear();
+	for (int section = 0; section < SECTION_COUNT; section++) {
+		if (sections & (1u << section)) {
+			sectionFacesOpaque[section].clear();
+			sectionFacesLiquid[section].clear();
+			sectionMinFaceY[section] = MAX_HEIGHT;
+			sectionMaxFaceY[section] = -1;
+			sectionUnmergedFaceCounts[section] = 0;
+		}
+	}
+
+	// Copy types (of the rebuilt sections) and masks once, so building never touches the chunk lock
+	thread_local ChunkSnapshot snapshot;
+	chunk->getSnapshot(snapshot, sections);
+
+	// Neighbor faces touching this chunk, a missing neighbor stays empty so its side is exposed
+	NeighborBorders neighborBorders;
+	const std::array<const std::shared_ptr<Chunk>*, static_cast<size_t>(Direction2D::COUNT)> neighborChunks = { &neighbors.px, &neighbors.nx, &neighbors.pz, &neighbors.nz };
 
-	// Get masks
-	Masks masks;
-	chunk->getMasks(masks);
+	for (size_t side = 0; side < neighborBorders.size(); side++) {
+		if (*neighborChunks[side]) {
+			(*neighborChunks[side])->getBorder(Direction2DInverted[side], neighborBorders[side]);
+		}
+	}
 
 	// Build faces
-	buildFaces(false, masks, chunk, neighbors);
-	buildFaces(true, masks, chunk, neighbors);
+	buildFaces(false, sections, snapshot, neighborBorders);
+	buildFaces(true, sections, snapshot, neighborBorders);
+
+	// Flatten sections in order, faces before the first rebuilt section are unchanged on the GPU
+	flattenSections(sectionFacesOpaque, sections, facesOpaque, pendingFirstFaceOpaque);
+	flattenSections(sectionFacesLiquid, sections, facesLiquid, pendingFirstFaceLiquid);
+
+	pendingMinY = MAX_HEIGHT;
+	pendingMaxY = -1;
+	pendingUnmergedFaceCount = 0;
+	size_t retainedBytes = 0;
+
+	for (int section = 0; section < SECTION_COUNT; section++) {
+		pendingMinY = std::min(pendingMinY, sectionMinFaceY[section]);
+		pendingMaxY = std::max(pendingMaxY, sectionMaxFaceY[section]);
+		pendingUnmergedFaceCount += sectionUnmergedFaceCounts[section];
+		retainedBytes += (sectionFacesOpaque[section].capacity() + sectionFacesLiquid[section].capacity()) * sizeof(Face);
+	}
+
+	pendingFaceCount = facesOpaque.size() + facesLiquid.size();
+	pendingOccluderHeights = getOccluderHeights(snapshot.masks);
+	sectionFaceBytes.store(retainedBytes);
+	built = true;
 
 	meshStateOpaque.store(MeshState::HANDOFF);
 	meshStateLiquid.store(MeshState::HANDOFF);
 }
 
-void ChunkMesh::emitFaces(uint32_t mask, int y, int z, uint8_t direction, const std::shared_ptr<Chunk> chunk, const bool liquid) {
-	std::vector<Face>& faceVector = liquid ? facesLiquid : facesOpaque;
+// Rows a tile is opaque all the way up from the bottom, anything above can't be relied on to hide what's behind it
+ChunkMesh::OccluderHeights ChunkMesh::getOccluderHeights(const Masks& masks) {
+	ZoneScopedN("Occluder Heights");
 
-	while (mask) {
-		int x = std::countr_zero(mask);
-		mask &= mask - 1;
+	constexpr uint32_t TILE_BITS = (1u << OCCLUDER_TILE_SIZE) - 1;
 
-		glm::ivec3 position = glm::ivec3(x, y, z);
+	OccluderHeights heights = {};
 
-		// Get type
-		// Really don't like accessing the voxel type here so many times
-		const uint8_t type = static_cast<uint8_t>(chunk->getVoxelType(position));
+	for (int tileZ = 0; tileZ < OCCLUDER_TILES; tileZ++) {
+		for (int tileX = 0; tileX < OCCLUDER_TILES; tileX++) {
+			const uint32_t tileMask = TILE_BITS << (tileX * OCCLUDER_TILE_SIZE);
+			int height = 0;
 
-		// Build face
-		Face face;
-		FacePacked::setPosition(face, position);
-		FacePacked::setFace(face, direction);
-		FacePacked::setTexID(face, type);
+			while (height < MAX_HEIGHT) {
+				bool solid = true;
+
+				for (int z = tileZ * OCCLUDER_TILE_SIZE; z < (tileZ + 1) * OCCLUDER_TILE_SIZE && solid; z++) {
+					solid = (masks.opaque[height * CHUNK_SIZE + z] & tileMask) == tileMask;
+				}
+
+				if (!solid) {
+					break;
+				}
 
-		faceVector.push_back(face);
+				height++;
+			}
+
+			heights[tileZ * OCCLUDER_TILES + tileX] = static_cast<uint16_t>(height);
+		}
 	}
+
+	return heights;
 }
 
-void ChunkMesh::buildFaces(const bool liquid, const Masks& masks, const std::shared_ptr<Chunk> chunk, const ChunkNeighbors& neighbors) {
+void ChunkMesh::flattenSections(const SectionFaces& sectionFaces, const uint32_t rebuiltSections, std::vector<Face>& faces, size_t& firstFace) {
+	faces.clear();
+
+	for (int section = 0; section < SECTION_COUNT; section++) {
+		// Kept at the earliest change if the last build wasn't uploaded yet
+		if ((rebuiltSections & (1u << section)) && faces.size() < firstFace) {
+			firstFace = faces.size();
+		}
+
+		faces.insert(faces.end(), sectionFaces[section].begin(), sectionFaces[section].end());
+	}
+}
+
+void ChunkMesh::emitFace(std::vector<Face>& faces, const glm::ivec3& position, const int width, const int height, const Direction direction, const VoxelType type) {
+	Face face;
+	FacePacked::setPosition(face, position);
+	FacePacked::setFace(face, static_cast<uint8_t>(direction));
+	FacePacked::setTexID(face, static_cast<uint8_t>(type));
+	FacePacked::setSize(face, width, height);
+
+	faces.push_back(face);
+}
+
+// Faces whose width runs along the mask bits (x), merged across rows stepping along z (Y faces) or y (Z faces)
+// Quads stay inside the section so each section's faces can be rebuilt on their own
+void ChunkMesh::mergeRowFaces(FaceRows& rows, const Direction direction, const bool stepAlongZ, const int section, const ChunkSnapshot& snapshot, std::vector<Face>& faces) {
+	const int sectionMinY = section * SECTION_HEIGHT;
+	const int sectionMaxY = sectionMinY + SECTION_HEIGHT;
+
+	const int planeBegin = stepAlongZ ? sectionMinY : 0;
+	const int planeEnd = stepAlongZ ? sectionMaxY : CHUNK_SIZE;
+	const int lineBegin = stepAlongZ ? 0 : sectionMinY;
+	const int lineEnd = stepAlongZ ? CHUNK_SIZE : sectionMaxY;
+
+	for (int plane = planeBegin; plane < planeEnd; plane++) {
+		for (int line = lineBegin; line < lineEnd; line++) {
+			const int y = stepAlongZ ? plane : line;
+			const int z = stepAlongZ ? line : plane;
+			uint32_t& row = rows[y * CHUNK_SIZE + z];
+
+			while (row) {
+				const int x = std::countr_zero(row);
+				const VoxelType type = snapshot.getType(x, y, z);
+
+				// Widen over set bits of the same type, up to the largest size a packed face holds
+				int width = 1;
+				while (width < FacePacked::MAX_SIZE && x + width < CHUNK_SIZE && ((row >> (x + width)) & 1u) && snapshot.getType(x + width, y, z) == type) {
+					width++;
+				}
+
+				const uint32_t runMask = static_cast<uint32_t>(((uint64_t(1) << width) - 1) << x);
+				row &= ~runMask;
+
+				// Grow over following lines holding the whole run with the same type
+				int height = 1;
+				while (height < FacePacked::MAX_SIZE && line + height < lineEnd) {
+					const int nextY = stepAlongZ ? y : y + height;
+					const int nextZ = stepAlongZ ? z + height : z;
+					uint32_t& nextRow = rows[nextY * CHUNK_SIZE + nextZ];
+
+					if ((nextRow & runMask) != runMask) {
+						break;
+					}
+
+					bool sameType = true;
+					for (int i = 0; i < width && sameType; i++) {
+						sameType = snapshot.getType(x + i, nextY, nextZ) == type;
+					}
+
+					if (!sameType) {
+						break;
+					}
+
+					nextRow &= ~runMask;
+					height++;
+				}
+
+				emitFace(faces, glm::ivec3(x, y, z), width, height, direction, type);
+			}
+		}
+	}
+}
+
+// X faces, each x is its own plane, width runs along z and height along y (up to the section's top)
+void ChunkMesh::mergeColumnFaces(FaceRows& rows, const Direction direction, const int section, const ChunkSnapshot& snapshot, std::vector<Face>& faces) {
+	const int sectionMinY = section * SECTION_HEIGHT;
+	const int sectionMaxY = sectionMinY + SECTION_HEIGHT;
+
+	for (int x = 0; x < CHUNK_SIZE; x++) {
+		const uint32_t bit = 1u << x;
+
+		for (int y = sectionMinY; y < sectionMaxY; y++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				if ((rows[y * CHUNK_SIZE + z] & bit) == 0) {
+					continue;
+				}
+
+				const VoxelType type = snapshot.getType(x, y, z);
+
+				// Widen along z
+				int width = 1;
+				while (width < FacePacked::MAX_SIZE && z + width < CHUNK_SIZE && (rows[y * CHUNK_SIZE + z + width] & bit) && snapshot.getType(x, y, z + width) == type) {
+					width++;
+				}
+
+				// Grow along y while the whole span is present with the same type
+				int height = 1;
+				while (height < FacePacked::MAX_SIZE && y + height < sectionMaxY) {
+					bool fits = true;
+					for (int i = 0; i < width && fits; i++) {
+						fits = (rows[(y + height) * CHUNK_SIZE + z + i] & bit) && snapshot.getType(x, y + height, z + i) == type;
+					}
+
+					if (!fits) {
+						break;
+					}
+
+					height++;
+				}
+
+				for (int j = 0; j < height; j++) {
+					for (int i = 0; i < width; i++) {
+						rows[(y + j) * CHUNK_SIZE + z + i] &= ~bit;
+					}
+				}
+
+				emitFace(faces, glm::ivec3(x, y, z), width, height, direction, type);
+			}
+		}
+	}
+}
+
+void ChunkMesh::buildFaces(const bool liquid, const uint32_t sections, const ChunkSnapshot& snapshot, const NeighborBorders& neighborBorders) {
 	ZoneScopedN("Mask Meshing");
 
+	// Visible faces per direction, merged into quads once every row is known
+	thread_local FaceMasks faceMasks;
+	for (auto& rows : faceMasks.rows) {
+		rows.fill(0);
+	}
+
+	const Masks& masks = snapshot.masks;
 	const std::array<uint32_t, CHUNK_SIZE* MAX_HEIGHT>& occupancyMasks = liquid ? masks.liquid : masks.opaque;
-	const std::array<uint32_t, CHUNK_SIZE* MAX_HEIGHT>& occlusionMasks = liquid ? masks.filled : masks.opaque;
+	const std::array<uint32_t, CHUNK_SIZE* MAX_HEIGHT>& occlusionMasks = liquid ? snapshot.filled : masks.opaque;
+
+	// Neighbor border words for this pass
+	const auto getBorder = [&neighborBorders, liquid](const Direction2D side) -> const std::array<uint32_t, MAX_HEIGHT>& {
+		const BorderSlab& border = neighborBorders[static_cast<size_t>(side)];
+		return liquid ? border.filled : border.opaque;
+	};
+
+	const std::array<uint32_t, MAX_HEIGHT>& borderPX = getBorder(Direction2D::PX);
+	const std::array<uint32_t, MAX_HEIGHT>& borderNX = getBorder(Direction2D::NX);
+	const std::array<uint32_t, MAX_HEIGHT>& borderPZ = getBorder(Direction2D::PZ);
+	const std::array<uint32_t, MAX_HEIGHT>& borderNZ = getBorder(Direction2D::NZ);
+
+	const BorderRows borders = { &borderPX, &borderNX, &borderPZ, &borderNZ };
 
 	const int CHUNK_SIZE_MINUS_ONE = CHUNK_SIZE - 1;
 	const int MAX_HEIGHT_MINUS_ONE = MAX_HEIGHT - 1;
 
-	for (int y = 0; y < MAX_HEIGHT; y++) {
-		for (int z = 0; z < CHUNK_SIZE; z++) {
-			const int index = y * CHUNK_SIZE + z;
-			const uint32_t current = occupancyMasks[index];
+	for (int section = 0; section < SECTION_COUNT; section++) {
+		if ((sections & (1u << section)) == 0 || canSkipSection(section, occupancyMasks, occlusionMasks, borders)) {
+			continue;
+		}
 
-			// Skip empty
-			if (current == 0) {
-				continue;
-			}
+		const int sectionMinY = section * SECTION_HEIGHT;
 
-			// px
-			uint32_t px = current & ~(occlusionMasks[index] >> 1);
+		for (int y = sectionMinY; y < sectionMinY + SECTION_HEIGHT; y++) {
+			for (int z = 0; z < CHUNK_SIZE; z++) {
+				const int index = y * CHUNK_SIZE + z;
+				const uint32_t current = occupancyMasks[index];
 
-			if (neighbors.px) {
-				bool neighborSolid = neighbors.px->hasVoxel(glm::ivec3(0, y, z), !liquid);
-				if (neighborSolid) {
-					px &= ~(1u << CHUNK_SIZE_MINUS_ONE);
+				// Skip empty
+				if (current == 0) {
+					continue;
 				}
-			}
-			else {
-				px |= (current & (1u << CHUNK_SIZE_MINUS_ONE));
-			}
 
-			emitFaces(px, y, z, static_cast<uint8_t>(Direction::PX), chunk, liquid);
+				// px
+				uint32_t px = current & ~(occlusionMasks[index] >> 1);
+				px &= ~(((borderPX[y] >> z) & 1u) << CHUNK_SIZE_MINUS_ONE);
+
+				faceMasks.rows[static_cast<size_t>(Direction::PX)][index] = px;
 
-			// nx
-			uint32_t nx = current & ~(occlusionMasks[index] << 1);
+				// nx
+				uint32_t nx = current & ~(occlusionMasks[index] << 1);
+				nx &= ~((borderNX[y] >> z) & 1u);
 
-			if (neighbors.nx) {
-				bool neighborSolid = neighbors.nx->hasVoxel(glm::ivec3(CHUNK_SIZE_MINUS_ONE, y, z), !liquid);
-				if (neighborSolid) {
-					nx &= ~1u;
+				faceMasks.rows[static_cast<size_t>(Direction::NX)][index] = nx;
+
+				// pz
+				uint32_t pz;
+
+				if (z < CHUNK_SIZE_MINUS_ONE) {
+					pz = current & ~occlusionMasks[index + 1];
+				}
+				else {
+					pz = current & ~borderPZ[y];
 				}
-			}
-			else {
-				nx |= (current & 1u);
-			}
 
-			emitFaces(nx, y, z, static_cast<uint8_t>(Direction::NX), chunk, liquid);
+				faceMasks.rows[static_cast<size_t>(Direction::PZ)][index] = pz;
 
-			// pz
-			uint32_t pz;
+				// nz
+				uint32_t nz;
 
-			if (z < CHUNK_SIZE_MINUS_ONE) {
-				pz = current & ~occlusionMasks[index + 1];
-			}
-			else if (neighbors.pz) {
-				pz = current & ~neighbors.pz->getMask(y, 0, liquid);
-			}
-			else {
-				pz = current;
-			}
+				if (z > 0) {
+					nz = current & ~occlusionMasks[index - 1];
+				}
+				else {
+					nz = current & ~borderNZ[y];
+				}
 
-			emitFaces(pz, y, z, static_cast<uint8_t>(Direction::PZ), chunk, liquid);
+				faceMasks.rows[static_cast<size_t>(Direction::NZ)][index] = nz;
 
-			// nz
-			uint32_t nz;
+				// py
+				uint32_t py;
 
-			if (z > 0) {
-				nz = current & ~occlusionMasks[index - 1];
-			}
-			else if (neighbors.nz) {
-				nz = current & ~neighbors.nz->getMask(y, CHUNK_SIZE_MINUS_ONE, liquid);
-			}
-			else {
-				nz = current;
-			}
+				if (y < MAX_HEIGHT_MINUS_ONE) {
+					py = current & ~occlusionMasks[(y + 1) * CHUNK_SIZE + z];
+				}
+				else {
+					py = current;
+				}
 
-			emitFaces(nz, y, z, static_cast<uint8_t>(Direction::NZ), chunk, liquid);
+				faceMasks.rows[static_cast<size_t>(Direction::PY)][index] = py;
 
-			// py
-			uint32_t py;
+				// ny
+				uint32_t ny;
 
-			if (y < MAX_HEIGHT_MINUS_ONE) {
-				py = current & ~occlusionMasks[(y + 1) * CHUNK_SIZE + z];
-			}
-			else {
-				py = current;
+				if (y > 0) {
+					ny = current & ~occlusionMasks[(y - 1) * CHUNK_SIZE + z];
+				}
+				else {
+					ny = current;
+				}
+
+				faceMasks.rows[static_cast<size_t>(Direction::NY)][index] = ny;
+
+				if (px | nx | pz | nz | py | ny) {
+					sectionMinFaceY[section] = std::min(sectionMinFaceY[section], y);
+					sectionMaxFaceY[section] = std::max(sectionMaxFaceY[section], y);
+					sectionUnmergedFaceCounts[section] += std::popcount(px) + std::popcount(nx) + std::popcount(pz) + std::popcount(nz) + std::popcount(py) + std::popcount(ny);
+				}
 			}
+		}
 
-			emitFaces(py, y, z, static_cast<uint8_t>(Direction::PY), chunk, liquid);
+		// Greedy merge
+		ZoneScopedN("Greedy Merge");
 
-			// ny
-			uint32_t ny;
+		std::vector<Face>& faces = liquid ? sectionFacesLiquid[section] : sectionFacesOpaque[section];
 
-			if (y > 0) {
-				ny = current & ~occlusionMasks[(y - 1) * CHUNK_SIZE + z];
-			}
-			else {
-				ny = current;
-			}
+		mergeColumnFaces(faceMasks.rows[static_cast<size_t>(Direction::PX)], Direction::PX, section, snapshot, faces);
+		mergeColumnFaces(faceMasks.rows[static_cast<size_t>(Direction::NX)], Direction::NX, section, snapshot, faces);
+		mergeRowFaces(faceMasks.rows[static_cast<size_t>(Direction::PY)], Direction::PY, true, section, snapshot, faces);
+		mergeRowFaces(faceMasks.rows[static_cast<size_t>(Direction::NY)], Direction::NY, true, section, snapshot, faces);
+		mergeRowFaces(faceMasks.rows[static_cast<size_t>(Direction::PZ)], Direction::PZ, false, section, snapshot, faces);
+		mergeRowFaces(faceMasks.rows[static_cast<size_t>(Direction::NZ)], Direction::NZ, false, section, snapshot, faces);
+	}
+}
+
+// Sections with nothing in this pass, or full and buried on every side, can't produce faces
+// Decided from the build's snapshot and borders (not the live chunk), so it agrees with the faces built from them
+bool ChunkMesh::canSkipSection(const int section, const MaskRows& occupancyMasks, const MaskRows& occlusionMasks, const BorderRows& borders) {
+	const int firstRow = section * SECTION_HEIGHT * CHUNK_SIZE;
+	const int endRow = firstRow + SECTION_HEIGHT * CHUNK_SIZE;
+
+	bool empty = true;
+	bool full = true;
+
+	for (int row = firstRow; row < endRow; row++) {
+		empty = empty && occupancyMasks[row] == 0;
+		full = full && occupancyMasks[row] == ~0u && occlusionMasks[row] == ~0u;
+	}
+
+	if (empty) {
+		return true;
+	}
 
-			emitFaces(ny, y, z, static_cast<uint8_t>(Direction::NY), chunk, liquid);
+	// Faces on the world's top and bottom are always emitted
+	if (!full || section == 0 || section == SECTION_COUNT - 1) {
+		return false;
+	}
+
+	// Layers just below and above the section
+	const int belowRow = firstRow - CHUNK_SIZE;
+	for (int z = 0; z < CHUNK_SIZE; z++) {
+		if (occlusionMasks[belowRow + z] != ~0u || occlusionMasks[endRow + z] != ~0u) {
+			return false;
 		}
 	}
+
+	for (const std::array<uint32_t, MAX_HEIGHT>* border : borders) {
+		for (int y = section * SECTION_HEIGHT; y < (section + 1) * SECTION_HEIGHT; y++) {
+			if ((*border)[y] != ~0u) {
+				return false;
+			}
+		}
+	}
+
+	return true;
 }
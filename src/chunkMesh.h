@@ -18,6 +18,8 @@
 #include <set>
 #include <bitset>
 #include <map>
+#include <array>
+#include <limits>
 
 struct ChunkNeighbors {
 	std::shared_ptr<Chunk> px;
@@ -35,15 +37,52 @@ enum class MeshState {
 
 class ChunkMesh {
 public:
-	void update();
-	void drawOpaque(const glm::ivec2 offset, const glm::mat4& view, const glm::mat4& projection, Shader& shader);
-	void drawWater(const glm::ivec2 offset, const glm::mat4& view, const glm::mat4& projection, Shader& shader);
-	void build(const std::shared_ptr<Chunk> chunk, const ChunkNeighbors& neighbors);
+	// Occluder tiles per side, each covering TILE_SIZE x TILE_SIZE columns
+	static constexpr int OCCLUDER_TILES = 4;
+	static constexpr int OCCLUDER_TILE_SIZE = CHUNK_SIZE / OCCLUDER_TILES;
+
+	using OccluderHeights = std::array<uint16_t, OCCLUDER_TILES * OCCLUDER_TILES>;
+
+	void update(FacePool& pool);
+	void build(const std::shared_ptr<Chunk> chunk, const ChunkNeighbors& neighbors, const uint32_t dirtySections = ALL_SECTIONS);
 
 	bool isValid() const {
 		return meshOpaque != nullptr && meshLiquid != nullptr;
 	}
 
+	// A finished build is waiting for update to upload it
+	bool hasPendingUpload() const {
+		return meshStateOpaque.load() == MeshState::HANDOFF || meshStateLiquid.load() == MeshState::HANDOFF;
+	}
+
+	// GPU bytes of the uploaded meshes plus the per-section faces kept for partial rebuilds (render thread only)
+	size_t getMemoryUsage() const {
+		return (meshOpaque ? meshOpaque->getMemoryUsage() : 0) + (meshLiquid ? meshLiquid->getMemoryUsage() : 0) + sectionFaceBytes.load();
+	}
+
+	// Uploaded meshes, drawn through the shared face pool (render thread only)
+	const Mesh* getOpaqueMesh() const { return meshOpaque.get(); }
+	const Mesh* getLiquidMesh() const { return meshLiquid.get(); }
+
+	// Lowest and highest Y holding a face in the uploaded mesh (min > max if there are none)
+	int getMinY() const { return minY; }
+	int getMaxY() const { return maxY; }
+
+	// Same per section, used for tighter culling bounds than the whole Y range
+	int getSectionMinY(const int section) const { return sectionMinY[section]; }
+	int getSectionMaxY(const int section) const { return sectionMaxY[section]; }
+
+	// Height of the solid block at the bottom of each tile (index tileZ * OCCLUDER_TILES + tileX), for software occlusion
+	const OccluderHeights& getOccluderHeights() const { return occluderHeights; }
+
+	// Merged quads in the uploaded meshes, and the per-voxel faces they replaced
+	size_t getFaceCount() const { return faceCount; }
+	size_t getUnmergedFaceCount() const { return unmergedFaceCount; }
+
+	// Same for the last build before it's uploaded, only safe on the thread that built it
+	size_t getBuiltFaceCount() const { return pendingFaceCount; }
+	size_t getBuiltUnmergedFaceCount() const { return pendingUnmergedFaceCount; }
+
 private:
 	std::atomic<MeshState> meshStateOpaque = MeshState::NONE;
 	std::unique_ptr<Mesh> meshOpaque = nullptr;
@@ -57,6 +96,46 @@ private:
 	std::vector<Face> facesLiquid;
 	std::mutex faceMutexLiquid;
 
+	// Faces per section, kept between builds so an edit only re-emits the sections it touched (under both face mutexes)
+	using SectionFaces = std::array<std::vector<Face>, SECTION_COUNT>;
+
+	SectionFaces sectionFacesOpaque;
+	SectionFaces sectionFacesLiquid;
+	std::array<int, SECTION_COUNT> sectionMinFaceY;
+	std::array<int, SECTION_COUNT> sectionMaxFaceY;
+	std::array<size_t, SECTION_COUNT> sectionUnmergedFaceCounts = {};
+	std::atomic<size_t> sectionFaceBytes = 0;
+	bool built = false;
+
+	// First face changed since the last upload, the ones before it are already on the GPU
+	static constexpr size_t NO_PENDING_FACES = std::numeric_limits<size_t>::max();
+	size_t pendingFirstFaceOpaque = NO_PENDING_FACES;
+	size_t pendingFirstFaceLiquid = NO_PENDING_FACES;
+
+	int minY = MAX_HEIGHT;
+	int maxY = -1;
+	std::array<int, SECTION_COUNT> sectionMinY;
+	std::array<int, SECTION_COUNT> sectionMaxY;
+	size_t faceCount = 0;
+	size_t unmergedFaceCount = 0;
+	OccluderHeights occluderHeights = {};
+
+	// Written while building (under the opaque face mutex), applied on upload
+	int pendingMinY = MAX_HEIGHT;
+	int pendingMaxY = -1;
+	size_t pendingFaceCount = 0;
+	size_t pendingUnmergedFaceCount = 0;
+	OccluderHeights pendingOccluderHeights = {};
+
+	// Visible face bits per direction, in the same (y * CHUNK_SIZE + z) row layout as the masks
+	using FaceRows = std::array<uint32_t, CHUNK_SIZE * MAX_HEIGHT>;
+
+	using NeighborBorders = std::array<BorderSlab, static_cast<size_t>(Direction2D::COUNT)>;
+
+	struct FaceMasks {
+		std::array<FaceRows, static_cast<size_t>(Direction::COUNT)> rows;
+	};
+
 	static bool isAdjacentBorderVoxel(const glm::ivec3& position) {
 		return position.x == -1 || position.x == CHUNK_SIZE || position.z == -1 || position.z == CHUNK_SIZE;
 	};
@@ -73,6 +152,17 @@ private:
 		return chunkPosition.x + chunkPosition.y * CHUNK_SIZE + chunkPosition.z * CHUNK_SIZE * MAX_HEIGHT;
 	};
 
-	void emitFaces(uint32_t mask, int y, int z, uint8_t direction, const std::shared_ptr<Chunk> chunk, const bool liquid);
-	void buildFaces(const bool liquid, const Masks& masks, const std::shared_ptr<Chunk> chunk, const ChunkNeighbors& neighbors);
+	static void uploadFaces(FacePool& pool, std::unique_ptr<Mesh>& mesh, std::vector<Face>& faces, size_t& firstFace);
+	static OccluderHeights getOccluderHeights(const Masks& masks);
+	static void flattenSections(const SectionFaces& sectionFaces, const uint32_t rebuiltSections, std::vector<Face>& faces, size_t& firstFace);
+
+	static void emitFace(std::vector<Face>& faces, const glm::ivec3& position, const int width, const int height, const Direction direction, const VoxelType type);
+	static void mergeRowFaces(FaceRows& rows, const Direction direction, const bool stepAlongZ, const int section, const ChunkSnapshot& snapshot, std::vector<Face>& faces);
+	static void mergeColumnFaces(FaceRows& rows, const Direction direction, const int section, const ChunkSnapshot& snapshot, std::vector<Face>& faces);
+	void buildFaces(const bool liquid, const uint32_t sections, const ChunkSnapshot& snapshot, const NeighborBorders& neighborBorders);
+
+	using MaskRows = std::array<uint32_t, CHUNK_SIZE * MAX_HEIGHT>;
+	using BorderRows = std::array<const std::array<uint32_t, MAX_HEIGHT>*, static_cast<size_t>(Direction2D::COUNT)>;
+
+	static bool canSkipSection(const int section, const MaskRows& occupancyMasks, const MaskRows& occlusionMasks, const BorderRows& borders);
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "chunkPool.h"
+#include <tracy/Tracy.hpp>
+
+ChunkPool::ChunkPool(const size_t maxPooled) : freeList(std::make_shared<FreeList>()) {
+	freeList->maxPooled = maxPooled;
+	freeList->chunks.reserve(maxPooled);
+}
+
+std::shared_ptr<Chunk> ChunkPool::acquire(const VoxelVolume& volume) {
+	ZoneScopedN("Acquire Chunk");
+
+	std::unique_ptr<Chunk> chunk;
+	{
+		std::lock_guard<std::mutex> lock(freeList->mutex);
+
+		if (!freeList->chunks.empty()) {
+			chunk = std::move(freeList->chunks.back());
+			freeList->chunks.pop_back();
+		}
+	}
+
+	if (chunk) {
+		chunk->load(volume);
+		reusedCount++;
+	}
+	else {
+		chunk = std::make_unique<Chunk>(volume);
+		allocatedCount++;
+	}
+
+	// Back into the free list once the last reference (slot, mesh job, neighbor) lets go
+	std::weak_ptr<FreeList> weakFreeList = freeList;
+	return std::shared_ptr<Chunk>(chunk.release(), [weakFreeList](Chunk* released) {
+		std::unique_ptr<Chunk> owned(released);
+
+		std::shared_ptr<FreeList> list = weakFreeList.lock();
+		if (!list) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(list->mutex);
+		if (list->chunks.size() < list->maxPooled) {
+			list->chunks.push_back(std::move(owned));
+		}
+	});
+}
+
+ChunkPoolStats ChunkPool::getStats() const {
+	ChunkPoolStats stats;
+	stats.allocated = allocatedCount.load();
+	stats.reused = reusedCount.load();
+
+	std::lock_guard<std::mutex> lock(freeList->mutex);
+	stats.pooled = freeList->chunks.size();
+
+	return stats;
+}
+
+VoxelVolume& ChunkPool::getScratchVolume() {
+	thread_local std::unique_ptr<VoxelVolume> volume = std::make_unique<VoxelVolume>();
+	return *volume;
+}
\ No newline at end of file
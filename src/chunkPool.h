@@ -0,0 +1,40 @@
+#pragma once
+
+#include "chunk.h"
+#include "structs.h"
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+struct ChunkPoolStats {
+	size_t pooled = 0;
+	uint64_t allocated = 0;
+	uint64_t reused = 0;
+};
+
+// Recycles unloaded chunks (and their section storage) instead of freeing them
+class ChunkPool {
+public:
+	ChunkPool(const size_t maxPooled);
+
+	std::shared_ptr<Chunk> acquire(const VoxelVolume& volume);
+	ChunkPoolStats getStats() const;
+
+	// Dense scratch volume owned by the calling thread, generators fill it before it's packed into a chunk
+	static VoxelVolume& getScratchVolume();
+
+private:
+	// Shared with chunk deleters, so chunks outliving the pool just get freed
+	struct FreeList {
+		std::vector<std::unique_ptr<Chunk>> chunks;
+		std::mutex mutex;
+		size_t maxPooled = 0;
+	};
+
+	std::shared_ptr<FreeList> freeList;
+
+	std::atomic<uint64_t> allocatedCount = 0;
+	std::atomic<uint64_t> reusedCount = 0;
+};
\ No newline at end of file
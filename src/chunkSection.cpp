@@ -0,0 +1,107 @@
+#include "chunkSection.h"
+
+ChunkSection::ChunkSection(const VoxelType type) {
+	fill(type);
+}
+
+void ChunkSection::set(const int index, const VoxelType type) {
+	int paletteIndex = findPaletteEntry(type);
+
+	if (paletteIndex < 0) {
+		paletteIndex = paletteSize;
+		palette[paletteSize++] = type;
+
+		const uint8_t requiredBits = getRequiredBits(paletteSize);
+		if (requiredBits != bitsPerIndex) {
+			repack(requiredBits);
+		}
+	}
+
+	// Uniform sections already hold the type everywhere
+	if (bitsPerIndex == 0) {
+		return;
+	}
+
+	writeIndex(index, static_cast<uint8_t>(paletteIndex));
+}
+
+void ChunkSection::fill(const VoxelType type) {
+	palette[0] = type;
+	paletteSize = 1;
+	bitsPerIndex = 0;
+
+	indices.clear();
+	indices.shrink_to_fit();
+}
+
+// Packs a dense block read in place, voxel (x, y, z) is at voxels[x + y * CHUNK_SIZE + z * zStride]
+// Only the types actually present end up in the palette
+void ChunkSection::assign(const Voxel* voxels, const int zStride) {
+	std::array<int, static_cast<size_t>(VoxelType::COUNT)> lookup;
+	lookup.fill(-1);
+
+	paletteSize = 0;
+	for (int z = 0; z < CHUNK_SIZE; z++) {
+		for (int i = 0; i < SECTION_HEIGHT * CHUNK_SIZE; i++) {
+			const VoxelType type = voxels[i + z * zStride].type;
+			int& entry = lookup[static_cast<size_t>(type)];
+
+			if (entry < 0) {
+				entry = paletteSize;
+				palette[paletteSize++] = type;
+			}
+		}
+	}
+
+	bitsPerIndex = getRequiredBits(paletteSize);
+
+	if (bitsPerIndex == 0) {
+		indices.clear();
+		indices.shrink_to_fit();
+		return;
+	}
+
+	// Recycled sections keep their storage unless it's far bigger than needed
+	const size_t wordCount = SECTION_VOXELS * bitsPerIndex / 64;
+	if (indices.capacity() > wordCount * 2) {
+		indices = std::vector<uint64_t>(wordCount, 0);
+	}
+	else {
+		indices.assign(wordCount, 0);
+	}
+
+	// Section rows are laid out like the source rows, only the z stride differs
+	for (int z = 0; z < CHUNK_SIZE; z++) {
+		for (int i = 0; i < SECTION_HEIGHT * CHUNK_SIZE; i++) {
+			const VoxelType type = voxels[i + z * zStride].type;
+			writeIndex(i + z * CHUNK_SIZE * SECTION_HEIGHT, static_cast<uint8_t>(lookup[static_cast<size_t>(type)]));
+		}
+	}
+}
+
+int ChunkSection::findPaletteEntry(const VoxelType type) const {
+	for (int i = 0; i < paletteSize; i++) {
+		if (palette[i] == type) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void ChunkSection::repack(const uint8_t newBitsPerIndex) {
+	std::vector<uint64_t> newIndices(SECTION_VOXELS * newBitsPerIndex / 64, 0);
+
+	// Going from uniform, every voxel is palette entry 0 which is all zero bits
+	if (bitsPerIndex != 0) {
+		const uint64_t newMask = (uint64_t(1) << newBitsPerIndex) - 1;
+
+		for (int i = 0; i < SECTION_VOXELS; i++) {
+			const int bit = i * newBitsPerIndex;
+			newIndices[bit >> 6] |= (uint64_t(readIndex(i)) & newMask) << (bit & 63);
+		}
+	}
+
+	indices = std::move(newIndices);
+	bitsPerIndex = newBitsPerIndex;
+}
\ No newline at end of file
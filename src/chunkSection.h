@@ -0,0 +1,80 @@
+#pragma once
+
+#include "structs.h"
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+enum class SectionFill : uint8_t {
+	Empty,
+	Solid,
+	Mixed,
+};
+
+// Palette compressed block of voxels, each voxel stores a bit-packed index into the palette
+// A section with a single palette entry stores no indices at all
+class ChunkSection {
+public:
+	ChunkSection(const VoxelType type = VoxelType::EMPTY);
+
+	VoxelType get(const int index) const {
+		if (bitsPerIndex == 0) {
+			return palette[0];
+		}
+
+		return palette[readIndex(index)];
+	}
+
+	void set(const int index, const VoxelType type);
+	void fill(const VoxelType type);
+	void assign(const Voxel* voxels, const int zStride);
+
+	bool isUniform() const { return bitsPerIndex == 0; }
+	SectionFill getFill() const {
+		return bitsPerIndex != 0 ? SectionFill::Mixed : (palette[0] == VoxelType::EMPTY ? SectionFill::Empty : SectionFill::Solid);
+	}
+	VoxelType getUniformType() const { return palette[0]; }
+
+	int getPaletteSize() const { return paletteSize; }
+	VoxelType getPaletteEntry(const int paletteIndex) const { return palette[paletteIndex]; }
+	uint8_t getPaletteIndex(const int index) const { return bitsPerIndex == 0 ? 0 : readIndex(index); }
+
+	size_t getMemoryUsage() const { return sizeof(ChunkSection) + indices.capacity() * sizeof(uint64_t); }
+
+	static int getIndex(const int x, const int y, const int z) {
+		return x + y * CHUNK_SIZE + z * CHUNK_SIZE * SECTION_HEIGHT;
+	}
+
+private:
+	std::array<VoxelType, static_cast<size_t>(VoxelType::COUNT)> palette = {};
+	uint8_t paletteSize = 1;
+
+	// Power of two so an index never straddles two words
+	uint8_t bitsPerIndex = 0;
+	std::vector<uint64_t> indices;
+
+	int findPaletteEntry(const VoxelType type) const;
+	void repack(const uint8_t newBitsPerIndex);
+
+	uint8_t readIndex(const int index) const {
+		const int bit = index * bitsPerIndex;
+		const uint64_t mask = (uint64_t(1) << bitsPerIndex) - 1;
+		return static_cast<uint8_t>((indices[bit >> 6] >> (bit & 63)) & mask);
+	}
+
+	void writeIndex(const int index, const uint8_t paletteIndex) {
+		const int bit = index * bitsPerIndex;
+		const uint64_t mask = (uint64_t(1) << bitsPerIndex) - 1;
+		uint64_t& word = indices[bit >> 6];
+		word = (word & ~(mask << (bit & 63))) | (uint64_t(paletteIndex) << (bit & 63));
+	}
+
+	static uint8_t getRequiredBits(const int paletteSize) {
+		if (paletteSize <= 1) return 0;
+		if (paletteSize <= 2) return 1;
+		if (paletteSize <= 4) return 2;
+		if (paletteSize <= 16) return 4;
+		return 8;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "frustum.h"
+#include <tracy/Tracy.hpp>
+
+namespace {
+	// Per plane, the corner furthest along its normal picked once for the whole batch (min or max of each axis)
+	struct PlaneCorner {
+		const float* x;
+		const float* y;
+		const float* z;
+	};
+
+	// A box is outside if that corner is behind any plane
+	void cullScalar(const Frustum& frustum, const std::array<PlaneCorner, 6>& corners, const size_t first, const size_t count, uint8_t* visible) {
+		for (size_t i = first; i < count; i++) {
+			bool inside = true;
+
+			for (size_t plane = 0; plane < frustum.planes.size() && inside; plane++) {
+				const glm::vec4& p = frustum.planes[plane];
+				inside = p.x * corners[plane].x[i] + p.y * corners[plane].y[i] + p.z * corners[plane].z[i] + p.w >= 0.0f;
+			}
+
+			visible[i] = inside ? 1 : 0;
+		}
+	}
+
+#if SIMD_X86
+	// Four boxes per step, the tail is left to the scalar path
+	SIMD_TARGET_SSE41 size_t cullSSE41(const Frustum& frustum, const std::array<PlaneCorner, 6>& corners, const size_t count, uint8_t* visible) {
+		const __m128 zero = _mm_setzero_ps();
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4) {
+			__m128 outside = _mm_setzero_ps();
+
+			for (size_t plane = 0; plane < frustum.planes.size(); plane++) {
+				const glm::vec4& p = frustum.planes[plane];
+				__m128 distance = _mm_set1_ps(p.w);
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p.x), _mm_loadu_ps(corners[plane].x + i)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p.y), _mm_loadu_ps(corners[plane].y + i)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p.z), _mm_loadu_ps(corners[plane].z + i)));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+			}
+
+			const int outsideBits = _mm_movemask_ps(outside);
+			for (int lane = 0; lane < 4; lane++) {
+				visible[i + lane] = ((outsideBits >> lane) & 1) ? 0 : 1;
+			}
+		}
+
+		return i;
+	}
+
+	SIMD_TARGET_AVX2 size_t cullAVX2(const Frustum& frustum, const std::array<PlaneCorner, 6>& corners, const size_t count, uint8_t* visible) {
+		const __m256 zero = _mm256_setzero_ps();
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8) {
+			__m256 outside = _mm256_setzero_ps();
+
+			for (size_t plane = 0; plane < frustum.planes.size(); plane++) {
+				const glm::vec4& p = frustum.planes[plane];
+				__m256 distance = _mm256_set1_ps(p.w);
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(p.x), _mm256_loadu_ps(corners[plane].x + i)));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(p.y), _mm256_loadu_ps(corners[plane].y + i)));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(p.z), _mm256_loadu_ps(corners[plane].z + i)));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+			}
+
+			const int outsideBits = _mm256_movemask_ps(outside);
+			for (int lane = 0; lane < 8; lane++) {
+				visible[i + lane] = ((outsideBits >> lane) & 1) ? 0 : 1;
+			}
+		}
+
+		return i;
+	}
+#endif
+}
+
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProjection) {
+	const glm::mat4 vpt = glm::transpose(viewProjection);
+
+	return { {
+		vpt[3] + vpt[0],
+		vpt[3] - vpt[0],
+		vpt[3] + vpt[1],
+		vpt[3] - vpt[1],
+		vpt[3] + vpt[2],
+		vpt[3] - vpt[2],
+	} };
+}
+
+// Same corner test as the batch, for one box
+bool Frustum::intersects(const glm::vec3& min, const glm::vec3& max) const {
+	for (const glm::vec4& p : planes) {
+		const glm::vec3 corner = glm::vec3(p.x >= 0.0f ? max.x : min.x, p.y >= 0.0f ? max.y : min.y, p.z >= 0.0f ? max.z : min.z);
+
+		if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0.0f) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void AABBBatch::clear() {
+	minX.clear();
+	minY.clear();
+	minZ.clear();
+	maxX.clear();
+	maxY.clear();
+	maxZ.clear();
+}
+
+void AABBBatch::push(const glm::vec3& min, const glm::vec3& max) {
+	minX.push_back(min.x);
+	minY.push_back(min.y);
+	minZ.push_back(min.z);
+	maxX.push_back(max.x);
+	maxY.push_back(max.y);
+	maxZ.push_back(max.z);
+}
+
+void AABBBatch::cull(const Frustum& frustum, std::vector<uint8_t>& visible, const Simd::Level level) const {
+	ZoneScopedN("Frustum Cull Batch");
+
+	const size_t count = size();
+	visible.resize(count);
+
+	std::array<PlaneCorner, 6> corners;
+	for (size_t plane = 0; plane < frustum.planes.size(); plane++) {
+		const glm::vec4& p = frustum.planes[plane];
+		corners[plane] = {
+			p.x >= 0.0f ? maxX.data() : minX.data(),
+			p.y >= 0.0f ? maxY.data() : minY.data(),
+			p.z >= 0.0f ? maxZ.data() : minZ.data(),
+		};
+	}
+
+	size_t first = 0;
+
+#if SIMD_X86
+	if (level >= Simd::Level::AVX2) {
+		first = cullAVX2(frustum, corners, count, visible.data());
+	}
+	else if (level >= Simd::Level::SSE41) {
+		first = cullSSE41(frustum, corners, count, visible.data());
+	}
+#endif
+
+	cullScalar(frustum, corners, first, count, visible.data());
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "simd.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include <cstdint>
+
+// Left, right, bottom, top, near and far planes, facing inwards
+struct Frustum {
+	std::array<glm::vec4, 6> planes;
+
+	static Frustum fromViewProjection(const glm::mat4& viewProjection);
+
+	// Single box test, batches of boxes go through AABBBatch
+	bool intersects(const glm::vec3& min, const glm::vec3& max) const;
+};
+
+// Boxes kept as separate coordinate arrays, so the plane test runs over several boxes at once
+class AABBBatch {
+public:
+	void clear();
+	void push(const glm::vec3& min, const glm::vec3& max);
+	size_t size() const { return minX.size(); }
+
+	// One entry per box, 1 if it touches the frustum
+	void cull(const Frustum& frustum, std::vector<uint8_t>& visible, const Simd::Level level = Simd::getLevel()) const;
+
+private:
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+};
\ No newline at end of file
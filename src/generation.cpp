@@ -5,6 +5,7 @@
 #include <glm/gtc/constants.hpp>
 #include <algorithm>
 #include <cmath>
+#include <tracy/Tracy.hpp>
 
 namespace {
 	// Heightmap nodes
@@ -302,13 +303,16 @@ namespace Generation {
 		return treePoints;
 	}
 
-	static void terrainPass(const uint32_t seed, const glm::ivec2& offset, VoxelVolumePtr volume) {
+	static void terrainPass(const uint32_t seed, const glm::ivec2& offset, VoxelVolume& volume) {
 		HeightMapPtr heightmap = generateHeightMap(seed, offset);
-		auto& heightmapRef = *heightmap;
+		fillTerrain(*heightmap, volume);
+	}
 
+	// Column at a time, walking down from the surface
+	static void fillTerrainColumns(const HeightMap& heights, VoxelVolume& volume) {
 		for (int x = 0; x < CHUNK_SIZE; x++) {
 			for (int z = 0; z < CHUNK_SIZE; z++) {
-				const int heightValue = heightmapRef[x + z * CHUNK_SIZE];
+				const int heightValue = heights[x + z * CHUNK_SIZE];
 				const int baseIndex = x + z * CHUNK_SIZE * MAX_HEIGHT;
 
 				int y = heightValue;
@@ -317,48 +321,182 @@ namespace Generation {
 				if (heightValue < WATER_HEIGHT) {
 					// Water (water height to height value)
 					for (y = WATER_HEIGHT; y > heightValue; y--) {
-						volume->voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::WATER;
-						volume->voxelCount++;
+						volume.voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::WATER;
+						volume.voxelCount++;
 					}
 
 					// Sand (height value to 3 blocks under)
 					for (; y >= heightValue - 3 && y >= 0; y--) {
-						volume->voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::SAND;
-						volume->voxelCount++;
+						volume.voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::SAND;
+						volume.voxelCount++;
 					}
 				}
 				// Beach
 				else if (heightValue == WATER_HEIGHT) {
 					// Sand (height value to 2 blocks under)
 					for (; y >= heightValue - 2 && y >= 0; y--) {
-						volume->voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::SAND;
-						volume->voxelCount++;
+						volume.voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::SAND;
+						volume.voxelCount++;
 					}
 				}
 				// Land
 				else {
 					// Grass (first block only)
-					volume->voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::GRASS;
-					volume->voxelCount++;
+					volume.voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::GRASS;
+					volume.voxelCount++;
 					y--;
 
 					// Dirt (the 3 blocks under grass)
 					for (; y >= heightValue - 3 && y >= 0; y--) {
-						volume->voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::DIRT;
-						volume->voxelCount++;
+						volume.voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::DIRT;
+						volume.voxelCount++;
 					}
 				}
 
 				// Stone (underground)
 				for (; y >= 0; y--) {
-					volume->voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::STONE;
-					volume->voxelCount++;
+					volume.voxels[baseIndex + y * CHUNK_SIZE].type = VoxelType::STONE;
+					volume.voxelCount++;
 				}
 			}
 		}
 	}
 
-	static void treePass(const uint32_t seed, const glm::ivec2& offset, VoxelVolumePtr volume) {
+#if SIMD_X86
+	static_assert(CHUNK_SIZE == 32, "Terrain rows fill a 32 voxel row per iteration");
+
+	// Heights and y are unsigned bytes, so the row fill only handles columns up to 256 tall
+	constexpr bool TERRAIN_ROWS_FIT_BYTES = MAX_HEIGHT <= 256;
+
+	// Heights of one row across x as bytes, and the highest filled y (surface or water)
+	static int packRowHeights(const HeightMap& heights, const int z, uint8_t* rowHeights) {
+		int top = WATER_HEIGHT;
+
+		for (int x = 0; x < CHUNK_SIZE; x++) {
+			const int height = heights[x + z * CHUNK_SIZE];
+			rowHeights[x] = static_cast<uint8_t>(height);
+			top = std::max(top, height);
+		}
+
+		return top;
+	}
+
+	// There's only a signed byte compare, flipping the top bit orders unsigned bytes the same way
+	SIMD_TARGET_SSE41 static __m128i cmpgtUnsignedSSE41(const __m128i a, const __m128i b) {
+		const __m128i bias = _mm_set1_epi8(-128);
+		return _mm_cmpgt_epi8(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+	}
+
+	SIMD_TARGET_AVX2 static __m256i cmpgtUnsignedAVX2(const __m256i a, const __m256i b) {
+		const __m256i bias = _mm256_set1_epi8(-128);
+		return _mm256_cmpgt_epi8(_mm256_xor_si256(a, bias), _mm256_xor_si256(b, bias));
+	}
+
+	// Same layers as the column fill, stone below the top layers, then sand, or grass over dirt on land, and water up to the water line
+	// The top layer depth saturates at 0, so short columns have no stone like the column fill
+	SIMD_TARGET_SSE41 static __m128i getTerrainTypesSSE41(const __m128i heights, const __m128i y) {
+		const __m128i waterHeight = _mm_set1_epi8(static_cast<char>(WATER_HEIGHT));
+
+		const __m128i land = cmpgtUnsignedSSE41(heights, waterHeight);
+		const __m128i depth = _mm_blendv_epi8(_mm_set1_epi8(3), _mm_set1_epi8(2), _mm_cmpeq_epi8(heights, waterHeight));
+
+		const __m128i above = cmpgtUnsignedSSE41(y, heights);
+		const __m128i stone = cmpgtUnsignedSSE41(_mm_subs_epu8(heights, depth), y);
+		const __m128i surface = _mm_andnot_si128(_mm_or_si128(above, stone), _mm_set1_epi8(-1));
+
+		const __m128i grass = _mm_and_si128(_mm_and_si128(land, surface), _mm_cmpeq_epi8(heights, y));
+		const __m128i dirt = _mm_andnot_si128(grass, _mm_and_si128(land, surface));
+		const __m128i sand = _mm_andnot_si128(land, surface);
+		const __m128i water = _mm_andnot_si128(cmpgtUnsignedSSE41(y, waterHeight), above);
+
+		__m128i types = _mm_and_si128(stone, _mm_set1_epi8(static_cast<char>(VoxelType::STONE)));
+		types = _mm_or_si128(types, _mm_and_si128(grass, _mm_set1_epi8(static_cast<char>(VoxelType::GRASS))));
+		types = _mm_or_si128(types, _mm_and_si128(dirt, _mm_set1_epi8(static_cast<char>(VoxelType::DIRT))));
+		types = _mm_or_si128(types, _mm_and_si128(sand, _mm_set1_epi8(static_cast<char>(VoxelType::SAND))));
+		return _mm_or_si128(types, _mm_and_si128(water, _mm_set1_epi8(static_cast<char>(VoxelType::WATER))));
+	}
+
+	SIMD_TARGET_AVX2 static __m256i getTerrainTypesAVX2(const __m256i heights, const __m256i y) {
+		const __m256i waterHeight = _mm256_set1_epi8(static_cast<char>(WATER_HEIGHT));
+
+		const __m256i land = cmpgtUnsignedAVX2(heights, waterHeight);
+		const __m256i depth = _mm256_blendv_epi8(_mm256_set1_epi8(3), _mm256_set1_epi8(2), _mm256_cmpeq_epi8(heights, waterHeight));
+
+		const __m256i above = cmpgtUnsignedAVX2(y, heights);
+		const __m256i stone = cmpgtUnsignedAVX2(_mm256_subs_epu8(heights, depth), y);
+		const __m256i surface = _mm256_andnot_si256(_mm256_or_si256(above, stone), _mm256_set1_epi8(-1));
+
+		const __m256i grass = _mm256_and_si256(_mm256_and_si256(land, surface), _mm256_cmpeq_epi8(heights, y));
+		const __m256i dirt = _mm256_andnot_si256(grass, _mm256_and_si256(land, surface));
+		const __m256i sand = _mm256_andnot_si256(land, surface);
+		const __m256i water = _mm256_andnot_si256(cmpgtUnsignedAVX2(y, waterHeight), above);
+
+		__m256i types = _mm256_and_si256(stone, _mm256_set1_epi8(static_cast<char>(VoxelType::STONE)));
+		types = _mm256_or_si256(types, _mm256_and_si256(grass, _mm256_set1_epi8(static_cast<char>(VoxelType::GRASS))));
+		types = _mm256_or_si256(types, _mm256_and_si256(dirt, _mm256_set1_epi8(static_cast<char>(VoxelType::DIRT))));
+		types = _mm256_or_si256(types, _mm256_and_si256(sand, _mm256_set1_epi8(static_cast<char>(VoxelType::SAND))));
+		return _mm256_or_si256(types, _mm256_and_si256(water, _mm256_set1_epi8(static_cast<char>(VoxelType::WATER))));
+	}
+
+	// Row at a time across x, every row is a contiguous span in the volume
+	SIMD_TARGET_SSE41 static void fillTerrainRowsSSE41(const HeightMap& heights, VoxelVolume& volume) {
+		alignas(16) uint8_t rowHeights[CHUNK_SIZE];
+
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			const int top = packRowHeights(heights, z, rowHeights);
+			const __m128i heightsLow = _mm_load_si128(reinterpret_cast<const __m128i*>(rowHeights));
+			const __m128i heightsHigh = _mm_load_si128(reinterpret_cast<const __m128i*>(rowHeights + 16));
+
+			for (int y = 0; y <= top; y++) {
+				const __m128i yValue = _mm_set1_epi8(static_cast<char>(y));
+				__m128i* row = reinterpret_cast<__m128i*>(&volume.voxels[y * CHUNK_SIZE + z * CHUNK_SIZE * MAX_HEIGHT]);
+
+				_mm_storeu_si128(row, getTerrainTypesSSE41(heightsLow, yValue));
+				_mm_storeu_si128(row + 1, getTerrainTypesSSE41(heightsHigh, yValue));
+			}
+		}
+	}
+
+	SIMD_TARGET_AVX2 static void fillTerrainRowsAVX2(const HeightMap& heights, VoxelVolume& volume) {
+		alignas(32) uint8_t rowHeights[CHUNK_SIZE];
+
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			const int top = packRowHeights(heights, z, rowHeights);
+			const __m256i rowHeightsVector = _mm256_load_si256(reinterpret_cast<const __m256i*>(rowHeights));
+
+			for (int y = 0; y <= top; y++) {
+				__m256i* row = reinterpret_cast<__m256i*>(&volume.voxels[y * CHUNK_SIZE + z * CHUNK_SIZE * MAX_HEIGHT]);
+				_mm256_storeu_si256(row, getTerrainTypesAVX2(rowHeightsVector, _mm256_set1_epi8(static_cast<char>(y))));
+			}
+		}
+	}
+#endif
+
+	// Expects a cleared volume, everything above the surface and water line is left empty
+	void fillTerrain(const HeightMap& heights, VoxelVolume& volume, const Simd::Level level) {
+		ZoneScopedN("Fill Terrain");
+
+#if SIMD_X86
+		if (TERRAIN_ROWS_FIT_BYTES && level >= Simd::Level::SSE41) {
+			if (level >= Simd::Level::AVX2) {
+				fillTerrainRowsAVX2(heights, volume);
+			}
+			else {
+				fillTerrainRowsSSE41(heights, volume);
+			}
+
+			// Every column is filled from the bottom up to its surface, or the water line if that's higher
+			for (const int height : heights) {
+				volume.voxelCount += std::max(height, WATER_HEIGHT) + 1;
+			}
+			return;
+		}
+#endif
+
+		fillTerrainColumns(heights, volume);
+	}
+
+	static void treePass(const uint32_t seed, const glm::ivec2& offset, VoxelVolume& volume) {
 		// Get tree models
 		const std::vector<VoxelModel>& treeModels = getTreeModels();
 		const int treeModelsCount = static_cast<int>(treeModels.size());
@@ -431,19 +569,25 @@ namespace Generation {
 						if (modelLocal.x < 0 || modelLocal.x >= CHUNK_SIZE || modelLocal.y < 0 || modelLocal.y >= CHUNK_SIZE) continue;
 
 						const int chunkIndex = modelLocal.x + modelWorld.y * CHUNK_SIZE + modelLocal.y * CHUNK_SIZE * MAX_HEIGHT;
-						if (volume->voxels[chunkIndex].type == VoxelType::EMPTY) {
-							volume->voxelCount++;
+						if (volume.voxels[chunkIndex].type == VoxelType::EMPTY) {
+							volume.voxelCount++;
 						}
 
-						volume->voxels[chunkIndex] = modelVoxel;
+						volume.voxels[chunkIndex] = modelVoxel;
 					}
 				}
 			}
 		}
 	}
 
-	VoxelVolumePtr generateFlat() {
-		VoxelVolumePtr volume = std::make_shared<VoxelVolume>();
+	// Volumes are reused between chunks, so each generator starts from a cleared one
+	static void clearVolume(VoxelVolume& volume) {
+		volume.voxels.fill(Voxel{});
+		volume.voxelCount = 0;
+	}
+
+	void generateFlat(VoxelVolume& volume) {
+		clearVolume(volume);
 
 		for (int x = 0; x < CHUNK_SIZE; x++) {
 			for (int z = 0; z < CHUNK_SIZE; z++) {
@@ -451,33 +595,34 @@ namespace Generation {
 					int index = x + y * CHUNK_SIZE + z * CHUNK_SIZE * MAX_HEIGHT;
 
 					if (y < 3) {
-						volume->voxels[index].type = VoxelType::STONE;
+						volume.voxels[index].type = VoxelType::STONE;
 					}
 					else {
-						volume->voxels[index].type = VoxelType::GRASS;
+						volume.voxels[index].type = VoxelType::GRASS;
 					}
-					volume->voxelCount++;
+					volume.voxelCount++;
 				}
 			}
 		}
-
-		return volume;
 	}
 
-	VoxelVolumePtr generateSimple(const uint32_t seed, const glm::ivec2& offset) {
-		VoxelVolumePtr volume = std::make_shared<VoxelVolume>();
+	void generateSimple(const uint32_t seed, const glm::ivec2& offset, VoxelVolume& volume) {
+		clearVolume(volume);
 
 		terrainPass(seed, offset, volume);
-
-		return volume;
 	}
 
-	VoxelVolumePtr generateAdvanced(const uint32_t seed, const glm::ivec2& offset) {
-		VoxelVolumePtr volume = std::make_shared<VoxelVolume>();
+	bool generateAdvanced(const uint32_t seed, const glm::ivec2& offset, VoxelVolume& volume, const CancelCheck& isCancelled) {
+		clearVolume(volume);
 
 		terrainPass(seed, offset, volume);
+
+		if (isCancelled && isCancelled()) {
+			return false;
+		}
+
 		treePass(seed, offset, volume);
 
-		return volume;
+		return true;
 	}
-}
+}
\ No newline at end of file
@@ -1,20 +1,29 @@
 # pragma once
 
 #include "structs.h"
+#include "simd.h"
 #include <array>
 #include <memory>
 #include <vector>
 #include <random>
+#include <functional>
 #include <FastNoise/FastNoise.h>
 
 namespace Generation {
 	using NoiseOutputPtr = std::shared_ptr<std::array<float, CHUNK_SIZE* CHUNK_SIZE>>;
-	using HeightMapPtr = std::shared_ptr<std::array<int, CHUNK_SIZE* CHUNK_SIZE>>;
-	using VoxelVolumePtr = std::shared_ptr<VoxelVolume>;
+	using HeightMap = std::array<int, CHUNK_SIZE* CHUNK_SIZE>;
+	using HeightMapPtr = std::shared_ptr<HeightMap>;
 
-	VoxelVolumePtr generateFlat();
-	VoxelVolumePtr generateSimple(const uint32_t seed, const glm::ivec2& offset);
-	VoxelVolumePtr generateAdvanced(const uint32_t seed, const glm::ivec2& offset);
+	// Polled between passes, generation stops early (returning false) once it returns true
+	using CancelCheck = std::function<bool()>;
+
+	// Generators overwrite the whole volume, so callers can reuse one between chunks
+	void generateFlat(VoxelVolume& volume);
+	void generateSimple(const uint32_t seed, const glm::ivec2& offset, VoxelVolume& volume);
+	bool generateAdvanced(const uint32_t seed, const glm::ivec2& offset, VoxelVolume& volume, const CancelCheck& isCancelled = {});
+
+	// Terrain layers for a heightmap, vectorized across rows where the CPU allows
+	void fillTerrain(const HeightMap& heights, VoxelVolume& volume, const Simd::Level level = Simd::getLevel());
 
 	namespace Poisson {
 		std::vector<glm::ivec2> generatePoisson(const int size, const int radius, const int kSamples, std::mt19937& rng);
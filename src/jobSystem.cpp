@@ -0,0 +1,251 @@
+#include "jobSystem.h"
+#include <algorithm>
+#include <string>
+#include <tracy/Tracy.hpp>
+
+namespace {
+	// Index of the worker owning the current thread (-1 for non-worker threads)
+	thread_local int currentWorkerIndex = -1;
+
+	// Weight of the newest sample in the latency moving averages
+	constexpr float LATENCY_SMOOTHING = 0.05f;
+
+	std::chrono::microseconds smoothLatency(const std::chrono::microseconds average, const std::chrono::microseconds sample, const bool first) {
+		if (first) {
+			return sample;
+		}
+
+		const float smoothed = static_cast<float>(average.count()) * (1.0f - LATENCY_SMOOTHING) + static_cast<float>(sample.count()) * LATENCY_SMOOTHING;
+		return std::chrono::microseconds(static_cast<long long>(smoothed));
+	}
+}
+
+JobSystem::JobSystem(unsigned int workerCount) {
+	if (workerCount == 0) {
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	workers.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; i++) {
+		workers.push_back(std::make_unique<Worker>());
+	}
+
+	// Start threads once every worker exists, so stealing never sees a partial list
+	for (unsigned int i = 0; i < workerCount; i++) {
+		workers[i]->thread = std::thread(&JobSystem::workerLoop, this, static_cast<int>(i));
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stop.store(true);
+	}
+	sleepCondition.notify_all();
+
+	for (auto& worker : workers) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+	}
+
+	// Jobs still queued never run, shutdown only waits for the ones already running
+	for (auto& worker : workers) {
+		worker->queue.clear();
+	}
+	queuedCount.store(0);
+}
+
+void JobSystem::submit(const JobType type, const float priority, std::function<void()> function, const uint64_t tag) {
+	Job job;
+	job.function = std::move(function);
+	job.priority = priority;
+	job.type = type;
+	job.tag = tag;
+	job.submitTime = std::chrono::steady_clock::now();
+
+	// Jobs spawned by a worker stay local, others are spread round robin
+	const int workerIndex = currentWorkerIndex >= 0 ? currentWorkerIndex : static_cast<int>(nextWorker.fetch_add(1) % workers.size());
+	Worker& worker = *workers[workerIndex];
+
+	// Counted before it can be popped (or cancelled), so the count never drops below zero, and bumped
+	// under the sleep mutex so a worker about to wait can't miss it
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedCount++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(worker.queueMutex);
+		worker.queue.push_back(std::move(job));
+		std::push_heap(worker.queue.begin(), worker.queue.end(), jobCompare);
+	}
+
+	sleepCondition.notify_one();
+}
+
+// Recomputes the priority of every queued job of the given type from its tag
+void JobSystem::reprioritize(const JobType type, const std::function<float(uint64_t tag)>& priorityFunction) {
+	ZoneScopedN("Reprioritize Jobs");
+
+	for (auto& worker : workers) {
+		std::lock_guard<std::mutex> lock(worker->queueMutex);
+
+		bool changed = false;
+		for (Job& job : worker->queue) {
+			if (job.type == type) {
+				job.priority = priorityFunction(job.tag);
+				changed = true;
+			}
+		}
+
+		if (changed) {
+			std::make_heap(worker->queue.begin(), worker->queue.end(), jobCompare);
+		}
+	}
+}
+
+// Removes queued jobs of the given type matching the predicate, returns their tags (jobs already running are unaffected)
+std::vector<uint64_t> JobSystem::cancel(const JobType type, const std::function<bool(uint64_t tag)>& predicate) {
+	ZoneScopedN("Cancel Jobs");
+
+	std::vector<uint64_t> cancelledTags;
+
+	for (auto& worker : workers) {
+		std::lock_guard<std::mutex> lock(worker->queueMutex);
+
+		const auto removed = std::remove_if(worker->queue.begin(), worker->queue.end(), [&](const Job& job) {
+			if (job.type != type || !predicate(job.tag)) {
+				return false;
+			}
+
+			cancelledTags.push_back(job.tag);
+			return true;
+		});
+
+		if (removed != worker->queue.end()) {
+			worker->queue.erase(removed, worker->queue.end());
+			std::make_heap(worker->queue.begin(), worker->queue.end(), jobCompare);
+		}
+	}
+
+	queuedCount -= cancelledTags.size();
+	return cancelledTags;
+}
+
+JobSystemStats JobSystem::getStats() const {
+	JobSystemStats stats;
+	stats.workerCount = getWorkerCount();
+	stats.queueDepth = queuedCount.load();
+	stats.stealCount = stealCount.load();
+
+	std::lock_guard<std::mutex> lock(statsMutex);
+	stats.types = typeStats;
+
+	return stats;
+}
+
+void JobSystem::workerLoop(const int workerIndex) {
+	currentWorkerIndex = workerIndex;
+	tracy::SetThreadName(("Worker Thread " + std::to_string(workerIndex)).c_str());
+
+	// Checked before every job, so shutdown doesn't wait for the queues to drain
+	while (!stop.load()) {
+		Job job;
+
+		// Own queue first, then try to steal
+		if (!popJob(workerIndex, job) && !stealJob(workerIndex, job)) {
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			sleepCondition.wait(lock, [this] { return stop.load() || queuedCount.load() > 0; });
+
+			continue;
+		}
+
+		queuedCount--;
+
+		// Run job
+		const auto startTime = std::chrono::steady_clock::now();
+		{
+			ZoneScopedN("Run Job");
+			job.function();
+		}
+		const auto endTime = std::chrono::steady_clock::now();
+
+		recordJob(job, startTime, endTime);
+	}
+}
+
+bool JobSystem::popJob(const int workerIndex, Job& job) {
+	Worker& worker = *workers[workerIndex];
+	std::lock_guard<std::mutex> lock(worker.queueMutex);
+
+	if (worker.queue.empty()) {
+		return false;
+	}
+
+	std::pop_heap(worker.queue.begin(), worker.queue.end(), jobCompare);
+	job = std::move(worker.queue.back());
+	worker.queue.pop_back();
+
+	return true;
+}
+
+bool JobSystem::stealJob(const int workerIndex, Job& job) {
+	const int workerCount = getWorkerCount();
+
+	// Walk the other workers starting from the next one, taking their highest priority job
+	// Busy queues are skipped at first, then waited on if nothing else had work, so a missed lock
+	// can't look like empty queues (the sleep predicate would still be true, and the worker would spin)
+	for (int pass = 0; pass < 2; pass++) {
+		bool contended = false;
+
+		for (int offset = 1; offset < workerCount; offset++) {
+			Worker& victim = *workers[(workerIndex + offset) % workerCount];
+
+			std::unique_lock<std::mutex> lock(victim.queueMutex, std::defer_lock);
+			if (pass == 0) {
+				if (!lock.try_lock()) {
+					contended = true;
+					continue;
+				}
+			}
+			else {
+				lock.lock();
+			}
+
+			if (victim.queue.empty()) {
+				continue;
+			}
+
+			std::pop_heap(victim.queue.begin(), victim.queue.end(), jobCompare);
+			job = std::move(victim.queue.back());
+			victim.queue.pop_back();
+
+			stealCount++;
+			return true;
+		}
+
+		if (!contended) {
+			break;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::recordJob(const Job& job, const std::chrono::steady_clock::time_point startTime, const std::chrono::steady_clock::time_point endTime) {
+	const auto waitTime = std::chrono::duration_cast<std::chrono::microseconds>(startTime - job.submitTime);
+	const auto runTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+
+	std::lock_guard<std::mutex> lock(statsMutex);
+	JobTypeStats& stats = typeStats[static_cast<size_t>(job.type)];
+
+	const bool first = stats.completed == 0;
+	stats.completed++;
+
+	stats.averageWaitTime = smoothLatency(stats.averageWaitTime, waitTime, first);
+	stats.averageRunTime = smoothLatency(stats.averageRunTime, runTime, first);
+	stats.maxWaitTime = std::max(stats.maxWaitTime, waitTime);
+	stats.maxRunTime = std::max(stats.maxRunTime, runTime);
+}
\ No newline at end of file
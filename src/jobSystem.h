@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+enum class JobType : uint8_t {
+	Generation,
+	Meshing,
+	Occlusion,
+	COUNT
+};
+
+struct Job {
+	std::function<void()> function;
+	float priority = 0.0f;
+	JobType type = JobType::Generation;
+	uint64_t tag = 0;
+	std::chrono::steady_clock::time_point submitTime;
+};
+
+struct JobTypeStats {
+	uint64_t completed = 0;
+	std::chrono::microseconds averageWaitTime = std::chrono::microseconds(0);
+	std::chrono::microseconds averageRunTime = std::chrono::microseconds(0);
+	std::chrono::microseconds maxWaitTime = std::chrono::microseconds(0);
+	std::chrono::microseconds maxRunTime = std::chrono::microseconds(0);
+};
+
+struct JobSystemStats {
+	int workerCount = 0;
+	size_t queueDepth = 0;
+	uint64_t stealCount = 0;
+	std::array<JobTypeStats, static_cast<size_t>(JobType::COUNT)> types;
+};
+
+// Work-stealing scheduler, each worker owns a priority queue and steals from the others when it runs dry
+class JobSystem {
+public:
+	// A worker count of 0 uses hardware concurrency (minus the main thread)
+	JobSystem(unsigned int workerCount = 0);
+	~JobSystem();
+
+	void submit(const JobType type, const float priority, std::function<void()> function, const uint64_t tag = 0);
+	void reprioritize(const JobType type, const std::function<float(uint64_t tag)>& priorityFunction);
+	std::vector<uint64_t> cancel(const JobType type, const std::function<bool(uint64_t tag)>& predicate);
+
+	JobSystemStats getStats() const;
+	int getWorkerCount() const { return static_cast<int>(workers.size()); }
+
+private:
+	struct Worker {
+		std::vector<Job> queue;
+		std::mutex queueMutex;
+		std::thread thread;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<bool> stop = false;
+
+	std::atomic<size_t> queuedCount = 0;
+	std::atomic<uint64_t> stealCount = 0;
+	std::atomic<unsigned int> nextWorker = 0;
+
+	std::array<JobTypeStats, static_cast<size_t>(JobType::COUNT)> typeStats;
+	mutable std::mutex statsMutex;
+
+	void workerLoop(const int workerIndex);
+	bool popJob(const int workerIndex, Job& job);
+	bool stealJob(const int workerIndex, Job& job);
+	void recordJob(const Job& job, const std::chrono::steady_clock::time_point startTime, const std::chrono::steady_clock::time_point endTime);
+
+	// Max heap on priority (higher runs first)
+	static bool jobCompare(const Job& a, const Job& b) {
+		return a.priority < b.priority;
+	}
+};
\ No newline at end of file
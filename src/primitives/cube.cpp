@@ -14,23 +14,17 @@ Cube::~Cube() {
 }
 
 // Maybe add scaling later? (for LODs or something)
-void Cube::draw(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection, Shader& shader, const Material& material) {
+void Cube::draw(const glm::vec3& position, Shader& shader, const Material& material) {
 	// Create model matrix
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, position);
 
-	// Set matrix uniforms
+	// Set model uniform
 	shader.setUniform("model", model);
-	shader.setUniform("view", view);
-	shader.setUniform("projection", projection);
 
 	// Set color uniform
 	shader.setUniform("color", material.ambient);
 
-	// Calculate and set normal matrix
-	glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(view * model)));
-	shader.setUniform("normal", normal);
-
 	// Set material uniforms
 	shader.setUniform("material.ambient", material.ambient);
 	shader.setUniform("material.diffuse", material.diffuse);
@@ -10,7 +10,7 @@ public:
 	Cube();
 	~Cube();
 
-	void draw(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection, class Shader& shader, 
+	void draw(const glm::vec3& position, class Shader& shader, 
 		const Material& material = {});
 
 private:
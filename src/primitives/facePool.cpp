@@ -0,0 +1,329 @@
+#include "facePool.h"
+#include "shader.h"
+#include <tracy/Tracy.hpp>
+#include <algorithm>
+#include <cassert>
+
+FacePool::FacePool() {
+	glGenVertexArrays(1, &quadVAO);
+	glGenBuffers(1, &quadVBO);
+	glGenBuffers(1, &indirectBuffer);
+	glGenBuffers(1, &chunkOffsetBuffer);
+	glGenBuffers(1, &cullInputBuffer);
+	glGenBuffers(1, &drawCountBuffer);
+
+	for (CulledPass& culledPass : culledPasses) {
+		glGenBuffers(1, &culledPass.commandBuffer);
+		glGenBuffers(1, &culledPass.offsetBuffer);
+	}
+
+	// Draw counts and cull counters, reset before every cull
+	glBindBuffer(GL_PARAMETER_BUFFER, drawCountBuffer);
+	glBufferData(GL_PARAMETER_BUFFER, CULL_COUNTER_COUNT * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_PARAMETER_BUFFER, 0);
+
+	glGenBuffers(static_cast<GLsizei>(statsBuffers.size()), statsBuffers.data());
+	for (const GLuint statsBuffer : statsBuffers) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, statsBuffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, CULL_COUNTER_COUNT * sizeof(GLuint), nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// Shared quad
+	glBindVertexArray(quadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	grow(INITIAL_CAPACITY);
+}
+
+FacePool::~FacePool() {
+	glDeleteVertexArrays(1, &quadVAO);
+
+	const GLuint buffers[] = { quadVBO, faceBuffer, indirectBuffer, chunkOffsetBuffer, cullInputBuffer, drawCountBuffer };
+	glDeleteBuffers(6, buffers);
+
+	for (CulledPass& culledPass : culledPasses) {
+		glDeleteBuffers(1, &culledPass.commandBuffer);
+		glDeleteBuffers(1, &culledPass.offsetBuffer);
+	}
+
+	glDeleteBuffers(static_cast<GLsizei>(statsBuffers.size()), statsBuffers.data());
+}
+
+// May run on any thread (the last mesh reference can be dropped by a worker)
+void FacePool::deferFree(const FaceAllocation& allocation) {
+	if (allocation.capacity == 0) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(deferredMutex);
+	deferredFrees.push_back(allocation);
+}
+
+void FacePool::flushDeferred(const std::chrono::microseconds budget) {
+	ZoneScopedN("Flush Mesh Deletions");
+
+	// Allocations freed per lock, checked against the budget between batches
+	constexpr size_t BATCH_SIZE = 64;
+
+	const auto deadline = std::chrono::steady_clock::now() + budget;
+
+	std::vector<FaceAllocation> allocations;
+
+	do {
+		{
+			std::lock_guard<std::mutex> lock(deferredMutex);
+
+			if (deferredFrees.empty()) {
+				return;
+			}
+
+			const size_t count = std::min(deferredFrees.size(), BATCH_SIZE);
+
+			allocations.assign(deferredFrees.end() - count, deferredFrees.end());
+			deferredFrees.resize(deferredFrees.size() - count);
+		}
+
+		for (const FaceAllocation& freed : allocations) {
+			free(freed);
+		}
+	} while (std::chrono::steady_clock::now() < deadline);
+}
+
+size_t FacePool::getDeferredFreeCount() {
+	std::lock_guard<std::mutex> lock(deferredMutex);
+	return deferredFrees.size();
+}
+
+FaceAllocation FacePool::allocate(const size_t faceCount) {
+	if (faceCount == 0) {
+		return {};
+	}
+
+	const GLuint size = static_cast<GLuint>((faceCount + ALLOCATION_GRANULARITY - 1) / ALLOCATION_GRANULARITY * ALLOCATION_GRANULARITY);
+
+	// First fit, lowest offsets first keeps the buffer packed towards the front
+	auto it = std::find_if(freeBlocks.begin(), freeBlocks.end(), [size](const auto& block) {
+		return block.second >= size;
+	});
+
+	if (it == freeBlocks.end()) {
+		grow(std::max(capacity * 2, capacity + size));
+		it = std::find_if(freeBlocks.begin(), freeBlocks.end(), [size](const auto& block) {
+			return block.second >= size;
+		});
+	}
+
+	const FaceAllocation allocation = { it->first, size };
+
+	if (it->second > size) {
+		freeBlocks.emplace(it->first + size, it->second - size);
+	}
+	freeBlocks.erase(it);
+
+	allocatedFaces += size;
+	return allocation;
+}
+
+void FacePool::free(const FaceAllocation& allocation) {
+	if (allocation.capacity == 0) {
+		return;
+	}
+
+	allocatedFaces -= allocation.capacity;
+
+	auto it = freeBlocks.emplace(allocation.first, allocation.capacity).first;
+
+	// Merge with the following block
+	auto next = std::next(it);
+	if (next != freeBlocks.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		freeBlocks.erase(next);
+	}
+
+	// Merge into the preceding block
+	if (it != freeBlocks.begin()) {
+		auto previous = std::prev(it);
+		if (previous->first + previous->second == it->first) {
+			previous->second += it->second;
+			freeBlocks.erase(it);
+		}
+	}
+}
+
+void FacePool::upload(const FaceAllocation& allocation, const size_t firstFace, const Face* faces, const size_t faceCount) {
+	if (faceCount == 0) {
+		return;
+	}
+
+	// Meshes reallocate before uploading more than fits, an overrun is a bug in the caller
+	assert(firstFace + faceCount <= allocation.capacity && "Face pool upload overruns its allocation");
+
+	glBindBuffer(GL_ARRAY_BUFFER, faceBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, (allocation.first + firstFace) * sizeof(Face), faceCount * sizeof(Face), faces);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void FacePool::draw(const std::vector<DrawArraysIndirectCommand>& commands, const std::vector<glm::vec4>& chunkOffsets) {
+	ZoneScopedN("Face Pool Draw");
+
+	if (commands.empty()) {
+		return;
+	}
+
+	// Orphaned every call, the driver hands out fresh storage instead of waiting on the last draw
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, chunkOffsetBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, chunkOffsets.size() * sizeof(glm::vec4), chunkOffsets.data(), GL_STREAM_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_OFFSET_BINDING, chunkOffsetBuffer);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawArraysIndirectCommand), commands.data(), GL_STREAM_DRAW);
+
+	glBindVertexArray(quadVAO);
+	glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, nullptr, static_cast<GLsizei>(commands.size()), 0);
+	glBindVertexArray(0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void FacePool::cull(const std::vector<ChunkCullInput>& inputs, const Shader& cullShader, const bool occlusion) {
+	ZoneScopedN("Face Pool Cull");
+
+	culledCount = inputs.size();
+	if (inputs.empty()) {
+		return;
+	}
+
+	// Outputs only grow, sized for every input surviving
+	if (inputs.size() > culledCapacity) {
+		culledCapacity = inputs.size() + inputs.size() / 4;
+
+		for (CulledPass& culledPass : culledPasses) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, culledPass.commandBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, culledCapacity * sizeof(DrawArraysIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, culledPass.offsetBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, culledCapacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_COPY);
+		}
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, cullInputBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, inputs.size() * sizeof(ChunkCullInput), inputs.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	const std::array<GLuint, CULL_COUNTER_COUNT> zeroCounts = {};
+	glBindBuffer(GL_PARAMETER_BUFFER, drawCountBuffer);
+	glBufferSubData(GL_PARAMETER_BUFFER, 0, sizeof(zeroCounts), zeroCounts.data());
+	glBindBuffer(GL_PARAMETER_BUFFER, 0);
+
+	// Inputs, then commands and offsets for each pass, then the counts
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_INPUT_BINDING, cullInputBuffer);
+	for (size_t pass = 0; pass < culledPasses.size(); pass++) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_OUTPUT_BINDING + GLuint(pass) * 2, culledPasses[pass].commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_OUTPUT_BINDING + GLuint(pass) * 2 + 1, culledPasses[pass].offsetBuffer);
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COUNT_BINDING, drawCountBuffer);
+
+	cullShader.setUniform("inputCount", static_cast<int>(inputs.size()));
+	cullShader.setUniform("occlusionEnabled", occlusion ? 1 : 0);
+	glDispatchCompute(static_cast<GLuint>((inputs.size() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1, 1);
+
+	// Commands and counts are read by the draws, offsets by the vertex shaders, counters by the stats copy
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	readCullStats(inputs.size());
+}
+
+void FacePool::readCullStats(const size_t candidates) {
+	const size_t slot = statsFrame % CULL_STATS_LATENCY;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, drawCountBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, statsBuffers[slot]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, CULL_COUNTER_COUNT * sizeof(GLuint));
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	statsCandidates[slot] = candidates;
+	statsFrame++;
+
+	// The oldest slot was copied CULL_STATS_LATENCY - 1 frames ago
+	if (statsFrame < CULL_STATS_LATENCY) {
+		return;
+	}
+
+	const size_t oldest = statsFrame % CULL_STATS_LATENCY;
+	std::array<GLuint, CULL_COUNTER_COUNT> counters = {};
+
+	glBindBuffer(GL_COPY_READ_BUFFER, statsBuffers[oldest]);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counters), counters.data());
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	cullStats = { statsCandidates[oldest], counters[2], counters[3] };
+}
+
+void FacePool::drawCulled(const FacePass pass) {
+	ZoneScopedN("Face Pool Draw Culled");
+
+	if (culledCount == 0) {
+		return;
+	}
+
+	const CulledPass& culledPass = culledPasses[static_cast<size_t>(pass)];
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CHUNK_OFFSET_BINDING, culledPass.offsetBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culledPass.commandBuffer);
+	glBindBuffer(GL_PARAMETER_BUFFER, drawCountBuffer);
+
+	glBindVertexArray(quadVAO);
+	glMultiDrawArraysIndirectCount(GL_TRIANGLE_STRIP, nullptr, static_cast<GLintptr>(static_cast<size_t>(pass) * sizeof(GLuint)), static_cast<GLsizei>(culledCount), 0);
+	glBindVertexArray(0);
+
+	glBindBuffer(GL_PARAMETER_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Immutable storage can't resize, so growing copies into a larger buffer and repoints the VAO
+void FacePool::grow(const size_t minCapacity) {
+	ZoneScopedN("Face Pool Grow");
+
+	GLuint newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, minCapacity * sizeof(Face), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	if (faceBuffer != 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, faceBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * sizeof(Face));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glDeleteBuffers(1, &faceBuffer);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// The new space joins the free list (merging with a free block at the old end)
+	const FaceAllocation added = { static_cast<GLuint>(capacity), static_cast<GLuint>(minCapacity - capacity) };
+	allocatedFaces += added.capacity;
+
+	faceBuffer = newBuffer;
+	capacity = minCapacity;
+
+	free(added);
+	bindFaceAttributes();
+}
+
+void FacePool::bindFaceAttributes() {
+	glBindVertexArray(quadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, faceBuffer);
+
+	// Per instance, base instance of each draw selects the mesh's range
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Face), (void*)offsetof(Face, packed));
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisor(1, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
\ No newline at end of file
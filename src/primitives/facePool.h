@@ -0,0 +1,140 @@
+#pragma once
+
+#include "structs.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <map>
+#include <array>
+#include <mutex>
+#include <chrono>
+
+// Range of the pool owned by one mesh, in faces
+struct FaceAllocation {
+	GLuint first = 0;
+	GLuint capacity = 0;
+};
+
+// Layout glMultiDrawArraysIndirect reads
+struct DrawArraysIndirectCommand {
+	GLuint count = 0;
+	GLuint instanceCount = 0;
+	GLuint first = 0;
+	GLuint baseInstance = 0;
+};
+
+// Per chunk input of the cull compute shader (std430, matches cull.comp.glsl)
+struct ChunkCullInput {
+	glm::vec4 boundsMin;
+	glm::vec4 boundsMax;
+	DrawArraysIndirectCommand opaque;
+	DrawArraysIndirectCommand liquid;
+};
+
+// GPU cull results, read back a few frames late to avoid stalling
+struct CullStats {
+	size_t candidates = 0;
+	uint32_t frustumCulled = 0;
+	uint32_t occlusionCulled = 0;
+};
+
+enum class FacePass : uint8_t {
+	Opaque,
+	Liquid,
+	COUNT
+};
+
+// One instance buffer shared by every chunk mesh, so a whole pass draws with a single multi-draw (render thread only)
+// Owns GL objects, so it has to be created and destroyed while the context is current
+class FacePool {
+public:
+	FacePool();
+	~FacePool();
+
+	FaceAllocation allocate(const size_t faceCount);
+	void free(const FaceAllocation& allocation);
+
+	// Frees from any thread, the range is only returned to the pool by flushDeferred (render thread, within a time budget)
+	void deferFree(const FaceAllocation& allocation);
+	void flushDeferred(const std::chrono::microseconds budget);
+	size_t getDeferredFreeCount();
+	void upload(const FaceAllocation& allocation, const size_t firstFace, const Face* faces, const size_t faceCount);
+
+	// Draw n covers commands[n], its chunk offset is read from the SSBO by gl_DrawID
+	void draw(const std::vector<DrawArraysIndirectCommand>& commands, const std::vector<glm::vec4>& chunkOffsets);
+
+	// Frustum (and optionally Hi-Z occlusion) culls the inputs on the GPU into per-pass command lists and draw counts (cull shader must be bound)
+	void cull(const std::vector<ChunkCullInput>& inputs, const class Shader& cullShader, const bool occlusion);
+	void drawCulled(const FacePass pass);
+
+	size_t getCapacity() const { return capacity; }
+	size_t getAllocatedFaces() const { return allocatedFaces; }
+	size_t getFreeBlockCount() const { return freeBlocks.size(); }
+	CullStats getCullStats() const { return cullStats; }
+
+	FacePool(const FacePool&) = delete;
+	FacePool& operator=(const FacePool&) = delete;
+
+private:
+	static constexpr size_t INITIAL_CAPACITY = size_t(4) * 1024 * 1024;
+
+	// Allocations are rounded up to this many faces, limits fragmentation from small size changes
+	static constexpr size_t ALLOCATION_GRANULARITY = 16;
+
+	// Binding of the per-draw chunk offsets (matches the vertex shaders)
+	static constexpr GLuint CHUNK_OFFSET_BINDING = 1;
+
+	// Bindings of the cull shader's buffers, the per-pass outputs follow the inputs
+	static constexpr GLuint CULL_INPUT_BINDING = 2;
+	static constexpr GLuint CULL_OUTPUT_BINDING = 3;
+	static constexpr GLuint CULL_COUNT_BINDING = 7;
+	static constexpr GLuint CULL_GROUP_SIZE = 64;
+
+	// Draw count per pass, then the frustum and occlusion culled counts
+	static constexpr size_t CULL_COUNTER_COUNT = 4;
+	static constexpr size_t CULL_STATS_LATENCY = 3;
+
+	GLuint faceBuffer = 0;
+	GLuint quadVAO = 0;
+	GLuint quadVBO = 0;
+	GLuint indirectBuffer = 0;
+	GLuint chunkOffsetBuffer = 0;
+
+	// Cull outputs, one command and offset list per pass plus a draw count for each
+	struct CulledPass {
+		GLuint commandBuffer = 0;
+		GLuint offsetBuffer = 0;
+	};
+
+	GLuint cullInputBuffer = 0;
+	GLuint drawCountBuffer = 0;
+	std::array<CulledPass, static_cast<size_t>(FacePass::COUNT)> culledPasses;
+	size_t culledCapacity = 0;
+	size_t culledCount = 0;
+
+	// Counters are copied into a ring and read once the GPU is done with them
+	std::array<GLuint, CULL_STATS_LATENCY> statsBuffers = {};
+	std::array<size_t, CULL_STATS_LATENCY> statsCandidates = {};
+	size_t statsFrame = 0;
+	CullStats cullStats;
+
+	size_t capacity = 0;
+	size_t allocatedFaces = 0;
+
+	// Free ranges by first face, adjacent ones are merged on free
+	std::map<GLuint, GLuint> freeBlocks;
+
+	std::vector<FaceAllocation> deferredFrees;
+	std::mutex deferredMutex;
+
+	static constexpr glm::vec3 vertices[4] = {
+		{ -0.5f, -0.5f, 0.0f },
+		{  0.5f, -0.5f, 0.0f },
+		{ -0.5f,  0.5f, 0.0f },
+		{  0.5f,  0.5f, 0.0f }
+	};
+
+	void grow(const size_t minCapacity);
+	void readCullStats(const size_t candidates);
+	void bindFaceAttributes();
+};
\ No newline at end of file
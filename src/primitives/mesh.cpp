@@ -1,61 +1,33 @@
 #include "mesh.h"
-#include "shader.h"
-#include <glm/gtc/matrix_transform.hpp>
+#include <tracy/Tracy.hpp>
 
-Mesh::Mesh(std::vector<Face>&& faceData) {
-	setupBuffers(faceData);
+Mesh::Mesh(FacePool& pool, std::vector<Face>&& faceData) : pool(pool) {
+	update(faceData, 0);
 }
 
+// May run on any thread (the last reference can be dropped by a worker), so freeing the range is deferred
 Mesh::~Mesh() {
-	glDeleteVertexArrays(1, &quadVAO);
-	glDeleteBuffers(1, &quadVBO);
-	glDeleteBuffers(1, &instanceVBO);
+	pool.deferFree(allocation);
 }
 
-void Mesh::draw(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection, Shader& shader) {
-	// Create model matrix
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, position);
-
-	// Set matrix uniforms
-	shader.setUniform("model", model);
-	shader.setUniform("view", view);
-	shader.setUniform("projection", projection);
-
-	// Calculate and set normal matrix
-	glm::mat3 normal = glm::mat3(glm::transpose(glm::inverse(view * model)));
-	shader.setUniform("normal", normal);
-
-	// Draw it
-	glBindVertexArray(quadVAO);
-	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, faceCount);
-	glBindVertexArray(0);
-}
-
-void Mesh::setupBuffers(const std::vector<Face>& faceData) {
-	// Generate buffers and arrays
-	glGenVertexArrays(1, &quadVAO);
-	glGenBuffers(1, &quadVBO);
-	glGenBuffers(1, &instanceVBO);
-
-	// Setup quad data
-	glBindVertexArray(quadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Set up instance data
-	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-	glBufferData(GL_ARRAY_BUFFER, faceData.size() * sizeof(Face), faceData.data(), GL_STATIC_DRAW);
-	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Face), (void*)offsetof(Face, packed));
-	glEnableVertexAttribArray(1);
-	glVertexAttribDivisor(1, 1);
-
-	// Unbind
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-
-	// Store counts
-	faceCount = static_cast<GLsizei>(faceData.size());
-}
+// Rewrites faces from firstFace on in place, moving to a new range (and uploading everything) when they don't fit
+// or have dropped well below the range, so a mesh's share of the pool follows its size both ways
+void Mesh::update(const std::vector<Face>& faceData, const size_t firstFace) {
+	ZoneScopedN("Mesh Patch");
+
+	const size_t newCount = faceData.size();
+	const bool grow = newCount > allocation.capacity;
+	const bool shrink = allocation.capacity > SHRINK_MIN_CAPACITY && newCount < allocation.capacity / 2;
+
+	if (grow || shrink) {
+		// GL orders uploads after earlier draws, so the old range can be handed out again right away
+		pool.free(allocation);
+		allocation = pool.allocate(newCount + newCount / 4);
+		pool.upload(allocation, 0, faceData.data(), newCount);
+	}
+	else if (firstFace < newCount) {
+		pool.upload(allocation, firstFace, faceData.data() + firstFace, newCount - firstFace);
+	}
+
+	faceCount = static_cast<GLuint>(newCount);
+}
\ No newline at end of file
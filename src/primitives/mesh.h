@@ -1,28 +1,32 @@
 #pragma once
 
 #include "structs.h"
+#include "facePool.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <vector>
 
+// A mesh's range of faces in the shared face pool, which has to outlive it
 class Mesh {
 public:
-	Mesh(std::vector<Face>&& faceData);
+	Mesh(FacePool& pool, std::vector<Face>&& faceData);
 	~Mesh();
 
-	void draw(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection, class Shader& shader);
+	void update(const std::vector<Face>& faceData, const size_t firstFace);
 
-private:
-	GLuint instanceVBO;
-	GLuint quadVAO, quadVBO;
-	GLsizei faceCount;
+	// Indirect command drawing this mesh from the pool
+	DrawArraysIndirectCommand getDrawCommand() const {
+		return { 4, faceCount, 0, allocation.first };
+	}
+
+	GLuint getFaceCount() const { return faceCount; }
+	size_t getMemoryUsage() const { return static_cast<size_t>(allocation.capacity) * sizeof(Face); }
 
-	static constexpr glm::vec3 vertices[4] = {
-		{ -0.5f, -0.5f, 0.0f },
-		{  0.5f, -0.5f, 0.0f },
-		{ -0.5f,  0.5f, 0.0f },
-		{  0.5f,  0.5f, 0.0f }
-	};
+private:
+	// Ranges shrink once the faces fit in half of them, small ones aren't worth moving
+	static constexpr GLuint SHRINK_MIN_CAPACITY = 64;
 
-	void setupBuffers(const std::vector<Face>& faceData);
+	FacePool& pool;
+	FaceAllocation allocation;
+	GLuint faceCount = 0;
 };
\ No newline at end of file
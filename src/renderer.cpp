@@ -6,6 +6,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <random>
+#include <algorithm>
+#include <cmath>
 
 static void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id, GLenum severity, GLsizei length, const char* message, const void* userParam)
 {
@@ -57,7 +59,9 @@ Renderer::Renderer(Window& window, ShaderManager& shaderManager, const glm::ivec
 	window(window), shaderManager(shaderManager),
 	defaultPostShader(shaderManager.get("src/shaders/basic.vert.glsl", "src/shaders/basic.frag.glsl")),
 	ssaoShader(shaderManager.get("src/shaders/basic.vert.glsl", "src/shaders/ssao.frag.glsl")),
-	blurShader(shaderManager.get("src/shaders/basic.vert.glsl", "src/shaders/blur.frag.glsl")) {
+	blurShader(shaderManager.get("src/shaders/basic.vert.glsl", "src/shaders/blur.frag.glsl")),
+	hiZShader(shaderManager.get("src/shaders/hiz.comp.glsl")),
+	ssaoSamplesUniform(ssaoShader.getUniform("samples")) {
 
 	// Enable OpenGL debug output
 	int flags;
@@ -86,6 +90,7 @@ Renderer::Renderer(Window& window, ShaderManager& shaderManager, const glm::ivec
 	// Setup FBO and quad
 	setResolution(resolution);
 	createQuad();
+	createCameraBuffer();
 
 	// Generate ssao kernel
 	generateSSAOKernel();
@@ -95,12 +100,15 @@ Renderer::~Renderer() {
 	destroyDefaultTextures();
 	destroyFBO();
 	destroyQuad();
+	destroyCameraBuffer();
+	destroyHiZ();
 	destroyGBuffer();
 	destroySSAOBuffers();
 }
 
 void Renderer::beginFrame() {
 	updateGlobals();
+	Shader::resetUniformStats();
 
 	// Bind FBO
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
@@ -248,6 +256,51 @@ void Renderer::drawQuad() {
 	glBindVertexArray(0);
 }
 
+// Run after the geometry pass, culling next frame reads it
+void Renderer::buildHiZ() {
+	useShader(&hiZShader);
+	hiZShader.setUniform("source", 0);
+
+	glActiveTexture(GL_TEXTURE0);
+
+	glm::ivec2 sourceSize = fboSize;
+	for (int level = 0; level < hiZLevels; level++) {
+		const glm::ivec2 targetSize = glm::max(glm::ivec2(hiZSize.x >> level, hiZSize.y >> level), glm::ivec2(1));
+
+		glBindTexture(GL_TEXTURE_2D, level == 0 ? depthStencilTexture : hiZTexture);
+		glBindImageTexture(0, hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		hiZShader.setUniform("sourceLevel", level == 0 ? 0 : level - 1);
+		hiZShader.setUniform("sourceSize", sourceSize);
+		hiZShader.setUniform("targetSize", targetSize);
+
+		glDispatchCompute((targetSize.x + 7) / 8, (targetSize.y + 7) / 8, 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+		sourceSize = targetSize;
+	}
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	hiZViewProjection = cameraViewProjection;
+	hiZValid = true;
+}
+
+// Occlusion tests stay off until a pyramid has been built at the current resolution
+void Renderer::bindHiZ(Shader& shader, const GLuint textureUnit) {
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_2D, hiZTexture);
+
+	shader.setUniform("hiZ", static_cast<int>(textureUnit));
+	shader.setUniform("hiZValid", hiZValid ? 1 : 0);
+	shader.setUniform("hiZSize", hiZSize);
+	shader.setUniform("hiZLevels", hiZLevels);
+	shader.setUniform("hiZViewProjection", hiZViewProjection);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
 // Shader management
 void Renderer::useShader(Shader* shader) {
 	if (shader == nullptr) {
@@ -282,10 +335,12 @@ void Renderer::setResolution(const glm::ivec2& newSize) {
 	destroyFBO();
 	destroyGBuffer();
 	destroySSAOBuffers();
+	destroyHiZ();
 
 	createFBO();
 	createGBuffer();
 	createSSAOBuffers();
+	createHiZ();
 }
 
 glm::ivec2 Renderer::getResolution() const {
@@ -300,6 +355,24 @@ glm::mat4 Renderer::getProjectionMatrix() const {
 	return glm::perspective(glm::radians(fov), getAspectRatio(), nearPlane, farPlane);
 }
 
+// Uploaded once per frame, every shader with the Camera block reads it from the same binding
+void Renderer::setCamera(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection) {
+	cameraViewProjection = projection * view;
+
+	const CameraUniforms camera = {
+		view,
+		projection,
+		cameraViewProjection,
+		glm::inverse(view),
+		glm::inverse(projection),
+		glm::vec4(position, 1.0f)
+	};
+
+	glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraUniforms), &camera);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
 void Renderer::setProjectionSettings(float fov, float nearPlane, float farPlane) {
 	this->fov = fov;
 	this->nearPlane = nearPlane;
@@ -573,9 +646,8 @@ void Renderer::runSSAOPass() {
 
 	ssaoShader.setUniform("projection", getProjectionMatrix());
 
-	for (int i = 0; i < ssaoKernelSize; i++) {
-		ssaoShader.setUniform("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
-	}
+	// Whole kernel in one call
+	ssaoShader.setUniform(ssaoSamplesUniform, std::span<const glm::vec3>(ssaoKernel.data(), ssaoKernelSize));
 
 	drawQuad();
 
@@ -661,3 +733,44 @@ void Renderer::destroyQuad() {
 		quadVBO = 0;
 	}
 }
+
+void Renderer::createCameraBuffer() {
+	glGenBuffers(1, &cameraUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraUniforms), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, cameraUBO);
+}
+
+void Renderer::destroyCameraBuffer() {
+	if (cameraUBO != 0) {
+		glDeleteBuffers(1, &cameraUBO);
+		cameraUBO = 0;
+	}
+}
+
+void Renderer::createHiZ() {
+	hiZSize = glm::max(fboSize / 2, glm::ivec2(1));
+	hiZLevels = 1 + static_cast<int>(std::floor(std::log2(static_cast<float>(std::max(hiZSize.x, hiZSize.y)))));
+
+	glGenTextures(1, &hiZTexture);
+	glBindTexture(GL_TEXTURE_2D, hiZTexture);
+	glTexStorage2D(GL_TEXTURE_2D, hiZLevels, GL_R32F, hiZSize.x, hiZSize.y);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	hiZValid = false;
+}
+
+void Renderer::destroyHiZ() {
+	if (hiZTexture != 0) {
+		glDeleteTextures(1, &hiZTexture);
+		hiZTexture = 0;
+	}
+
+	hiZValid = false;
+}
\ No newline at end of file
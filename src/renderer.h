@@ -4,9 +4,20 @@
 #include "window.h"
 #include "shaderManager.h"
 #include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
 #include <glad/glad.h>
 #include <iostream>
 
+// Per-frame camera data, laid out for std140 (see the Camera block in the world shaders)
+struct CameraUniforms {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseView;
+	glm::mat4 inverseProjection;
+	glm::vec4 position;
+};
+
 class Renderer {
 public:
 	Renderer(Window& window, ShaderManager& shaderManager, const glm::ivec2& resolution);
@@ -22,11 +33,19 @@ public:
 	void bindDeferred(Shader& shader);
 	void drawQuad();
 
+	// Max-depth pyramid of the G-buffer depth, tested against with the matrix it was rendered with
+	void buildHiZ();
+	void bindHiZ(Shader& shader, const GLuint textureUnit);
+
+	// Call on frames the pyramid isn't built, so occlusion doesn't resume against a stale one
+	void invalidateHiZ() { hiZValid = false; }
+
 	void useShader(Shader* shader);
 	void setPostProcessingShader();
 	void setPostProcessingShader(Shader* shader);
 
 	glm::mat4 getProjectionMatrix() const;
+	void setCamera(const glm::vec3& position, const glm::mat4& view, const glm::mat4& projection);
 	void setProjectionSettings(float fov, float nearPlane, float farPlane);
 
 	void setResolution(const glm::ivec2& newSize);
@@ -73,6 +92,9 @@ private:
 	Shader& defaultPostShader;
 	Shader& ssaoShader;
 	Shader& blurShader;
+	Shader& hiZShader;
+
+	UniformHandle ssaoSamplesUniform;
 
 	// Timing
 	float lastTime = 0.0f;
@@ -130,6 +152,18 @@ private:
 	GLuint quadVAO = 0;
 	GLuint quadVBO = 0;
 
+	// Camera
+	static constexpr GLuint CAMERA_BINDING = 0;
+	GLuint cameraUBO = 0;
+	glm::mat4 cameraViewProjection = glm::mat4(1.0f);
+
+	// Hi-Z, level 0 is half the depth buffer resolution
+	GLuint hiZTexture = 0;
+	glm::ivec2 hiZSize = glm::ivec2(0);
+	int hiZLevels = 0;
+	glm::mat4 hiZViewProjection = glm::mat4(1.0f);
+	bool hiZValid = false;
+
 	void updateGlobals();
 	void setGlobalUniforms();
 
@@ -152,4 +186,10 @@ private:
 
 	void createQuad();
 	void destroyQuad();
+
+	void createCameraBuffer();
+	void destroyCameraBuffer();
+
+	void createHiZ();
+	void destroyHiZ();
 };
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "shaderManager.h"
 #include "primitives/cube.h"
 #include "primitives/cubeMap.h"
+#include "primitives/mesh.h"
+#include "primitives/facePool.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
@@ -13,6 +15,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <chrono>
+#include <cmath>
 #include <tracy/Tracy.hpp>
 
 const float CAMERA_SPEED = 5.0f;
@@ -20,14 +23,15 @@ const float CAMERA_SPEED = 5.0f;
 // This looks way too messy
 WorldScene::WorldScene(SceneManager& sceneManager, ShaderManager& shaderManager, InputManager& inputManager, Window& window)
 	: sceneManager(sceneManager), shaderManager(shaderManager), inputManager(inputManager), window(window),
-	world(std::make_unique<World>(GenerationType::Advanced, 0u)), cube(std::make_unique<Cube>()), skybox(std::make_unique<CubeMap>()),
+	facePool(std::make_unique<FacePool>()), world(std::make_unique<World>(*facePool, GenerationType::Advanced, 0u)), cube(std::make_unique<Cube>()), skybox(std::make_unique<CubeMap>()),
 	worldTextureAtlas(std::make_unique<TextureAtlas>(1, 1, 1)),
 	shaderGeometry(shaderManager.get("src/shaders/geometry.vert.glsl", "src/shaders/geometry.frag.glsl")),
 	shaderLit(shaderManager.get("src/shaders/basic.vert.glsl", "src/shaders/lit.frag.glsl")),
 	shaderUnlit(shaderManager.get("src/shaders/basic.vert.glsl", "src/shaders/unlit.frag.glsl")),
 	shaderForward(shaderManager.get("src/shaders/forward.vert.glsl", "src/shaders/forward.frag.glsl")),
 	shaderWater(shaderManager.get("src/shaders/water.vert.glsl", "src/shaders/water.frag.glsl")),
-	shaderSkybox(shaderManager.get("src/shaders/skybox.vert.glsl", "src/shaders/skybox.frag.glsl")) {
+	shaderSkybox(shaderManager.get("src/shaders/skybox.vert.glsl", "src/shaders/skybox.frag.glsl")),
+	shaderCull(shaderManager.get("src/shaders/cull.comp.glsl")) {
 	tag = "Main";
 
 	// Add textures (must match voxel types)
@@ -157,34 +161,14 @@ void WorldScene::update(float deltaTime) {
 	light2Pos.x = 0.0f + radius * cos(angle);
 	light2Pos.z = 0.0f + radius * sin(angle);
 
-	// World generation
-	static float accumulatedTime = 0.0f;
-	accumulatedTime += deltaTime;
-
-	if (accumulatedTime >= 0.1f) {
-		// Chunk generation queue update
-		auto startTime = std::chrono::high_resolution_clock::now();
-		world->updateGenerationQueue(cameraPos, renderDistance);
-		auto endTime = std::chrono::high_resolution_clock::now();
-
-		profilingInfo.chunkQueueTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
-		if (profilingInfo.chunkQueueTime > profilingInfo.maxChunkQueueTime) {
-			profilingInfo.maxChunkQueueTime = profilingInfo.chunkQueueTime;
-		}
-
-		accumulatedTime = 0.0f;
-
-		// Chunk meshing queue update
-		startTime = std::chrono::high_resolution_clock::now();
-		world->updateMeshingQueue(cameraPos, renderDistance);
-		endTime = std::chrono::high_resolution_clock::now();
-
-		profilingInfo.meshQueueTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
-		if (profilingInfo.meshQueueTime > profilingInfo.maxMeshQueueTime) {
-			profilingInfo.maxMeshQueueTime = profilingInfo.meshQueueTime;
-		}
+	// Chunk generation queue update (returns immediately unless the camera crossed a chunk boundary)
+	auto startTime = std::chrono::high_resolution_clock::now();
+	world->updateGenerationQueue(cameraPos, renderDistance);
+	auto endTime = std::chrono::high_resolution_clock::now();
 
-		accumulatedTime = 0.0f;
+	profilingInfo.chunkQueueTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
+	if (profilingInfo.chunkQueueTime > profilingInfo.maxChunkQueueTime) {
+		profilingInfo.maxChunkQueueTime = profilingInfo.chunkQueueTime;
 	}
 }
 
@@ -232,6 +216,7 @@ void WorldScene::render(Renderer& renderer) {
 	glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 	renderer.setProjectionSettings(60.0f, 0.1f, 5000.0f);
 	glm::mat4 projection = renderer.getProjectionMatrix();
+	renderer.setCamera(cameraPos, view, projection);
 
 	// Set settings
 	renderer.setSSAOEnabled(ssaoEnabled);
@@ -246,9 +231,23 @@ void WorldScene::render(Renderer& renderer) {
 	// Update world
 	world->update(cameraPos, renderDistance, view, projection);
 
+	// Cull on the GPU against last frame's Hi-Z, the draws read the commands it writes
+	if (world->isGpuCullingEnabled()) {
+		renderer.useShader(&shaderCull);
+		renderer.bindHiZ(shaderCull, 1);
+		world->cullChunks(shaderCull);
+	}
+
 	// Geometry pass
 	renderer.beginGeometry();
-	renderGeometry(renderer, view, projection);
+	renderGeometry(renderer);
+
+	if (world->isGpuCullingEnabled() && world->isOcclusionCullingEnabled()) {
+		renderer.buildHiZ();
+	}
+	else {
+		renderer.invalidateHiZ();
+	}
 
 	// Deferred pass
 	renderer.beginDeferred();
@@ -262,12 +261,12 @@ void WorldScene::render(Renderer& renderer) {
 
 	// Opaque forward pass
 	renderer.beginForward();
-	renderExtras(renderer, view, projection);
+	renderExtras(renderer);
 	renderSkybox(renderer, view, projection);
 
 	// Translucent forward pass
 	renderer.beginTranslucent();
-	renderWater(renderer, view, projection);
+	renderWater(renderer);
 
 	auto endTime = std::chrono::high_resolution_clock::now();
 
@@ -277,7 +276,7 @@ void WorldScene::render(Renderer& renderer) {
 	}
 }
 
-void WorldScene::renderGeometry(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection) {
+void WorldScene::renderGeometry(Renderer& renderer) {
 	// Use texture atlas
 	glActiveTexture(GL_TEXTURE0);
 	worldTextureAtlas->use();
@@ -286,7 +285,7 @@ void WorldScene::renderGeometry(Renderer& renderer, const glm::mat4& view, const
 	shaderGeometry.setUniform("textureArray", 0);
 
 	auto worldDrawTimeStart = std::chrono::high_resolution_clock::now();
-	world->drawOpaque(cameraPos, renderDistance, view, projection, shaderGeometry, wireframeEnabled);
+	world->drawOpaque(cameraPos, renderDistance, wireframeEnabled);
 	auto worldDrawTimeEnd = std::chrono::high_resolution_clock::now();
 
 	profilingInfo.worldDrawTime = std::chrono::duration_cast<std::chrono::microseconds>(worldDrawTimeEnd - worldDrawTimeStart);
@@ -384,18 +383,18 @@ void WorldScene::renderUnlit(Renderer& renderer, const glm::mat4& view, const gl
 	glEnable(GL_DEPTH_TEST);
 }
 
-void WorldScene::renderExtras(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection) {
+void WorldScene::renderExtras(Renderer& renderer) {
 	renderer.useShader(&shaderForward);
 
-	cube->draw(lightPos, view, projection, shaderForward, lightCubeMaterial);
-	cube->draw(light2Pos, view, projection, shaderForward, lightCube2Material);
+	cube->draw(lightPos, shaderForward, lightCubeMaterial);
+	cube->draw(light2Pos, shaderForward, lightCube2Material);
 
 	// Directional light direction indicator
 	if (lightingDebugEnabled) {
 		glm::vec3 lightIndicatorPos = cameraPos + glm::normalize(-lightDirection) * 25.0f;
 		Material lightIndicatorMaterial = { glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 2.0f };
 
-		cube->draw(lightIndicatorPos, view, projection, shaderForward, lightIndicatorMaterial);
+		cube->draw(lightIndicatorPos, shaderForward, lightIndicatorMaterial);
 	}
 }
 
@@ -413,14 +412,14 @@ void WorldScene::renderSkybox(Renderer& renderer, const glm::mat4& view, const g
 	skybox->draw(untranslateView, projection, shaderSkybox);
 }
 
-void WorldScene::renderWater(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection) {
+void WorldScene::renderWater(Renderer& renderer) {
 	// Use texture atlas
 	glActiveTexture(GL_TEXTURE0);
 	worldTextureAtlas->use();
 
 	renderer.useShader(&shaderWater);
 
-	world->drawWater(cameraPos, renderDistance, view, projection, shaderWater, wireframeEnabled);
+	world->drawWater(cameraPos, renderDistance, wireframeEnabled);
 }
 
 void WorldScene::gui() {
@@ -439,19 +438,168 @@ void WorldScene::gui() {
 	ImGui::Text("Camera Position: (%.2f, %.2f, %.2f)", cameraPos.x, cameraPos.y, cameraPos.z);
 
 	ImGui::SliderFloat("Speed Multiplier", &speedMultiplier, 0.5f, 10.0f);
-	ImGui::SliderInt("Render Distance", &renderDistance, 6, 64);
+	ImGui::SliderInt("Render Distance", &renderDistance, 6, MAX_RENDER_DISTANCE);
 
 	ImGui::Text("Total Chunks: %d", world->getChunkCount());
-	ImGui::Text("Rendered Chunks: %d", world->getRenderedChunkCount());
+	ImGui::Text("Rendered Chunks: %d%s", world->getRenderedChunkCount(), world->isGpuCullingEnabled() ? " (Before GPU Culling)" : "");
+
+	// Greedy meshing savings, every face is an instanced quad of 4 vertices
+	const size_t renderedFaces = world->getRenderedFaceCount();
+	const size_t unmergedFaces = world->getRenderedUnmergedFaceCount();
+	const float faceReduction = unmergedFaces > 0 ? 100.0f * (1.0f - float(renderedFaces) / float(unmergedFaces)) : 0.0f;
+	ImGui::Text("Rendered Faces: %zu (Unmerged: %zu, -%.1f%%)", renderedFaces, unmergedFaces, faceReduction);
+	ImGui::Text("Rendered Vertices: %zu (Unmerged: %zu)", renderedFaces * 4, unmergedFaces * 4);
 
 	ImGui::Checkbox("Wireframe Mode", &wireframeEnabled);
 
+	bool gpuCullingEnabled = world->isGpuCullingEnabled();
+	if (ImGui::Checkbox("GPU Culling", &gpuCullingEnabled)) {
+		world->setGpuCullingEnabled(gpuCullingEnabled);
+	}
+
+	if (gpuCullingEnabled) {
+		bool occlusionCullingEnabled = world->isOcclusionCullingEnabled();
+		if (ImGui::Checkbox("Occlusion Culling", &occlusionCullingEnabled)) {
+			world->setOcclusionCullingEnabled(occlusionCullingEnabled);
+		}
+
+		const CullStats cullStats = facePool->getCullStats();
+		ImGui::Text("Culled: %u Frustum, %u Occlusion (of %zu)", cullStats.frustumCulled, cullStats.occlusionCulled, cullStats.candidates);
+	}
+	else {
+		bool softwareOcclusionEnabled = world->isSoftwareOcclusionEnabled();
+		if (ImGui::Checkbox("Software Occlusion", &softwareOcclusionEnabled)) {
+			world->setSoftwareOcclusionEnabled(softwareOcclusionEnabled);
+		}
+
+		if (softwareOcclusionEnabled) {
+			ImGui::Text("Occluded Chunks: %zu", world->getSoftwareOccludedCount());
+		}
+	}
+
 	if (ImGui::CollapsingHeader("Profiling Data")) {
 		ImGui::Text("Chunk Queue Time: %.2f ms (Max: %.2f ms)", profilingInfo.chunkQueueTime.count() / 1000.0f, profilingInfo.maxChunkQueueTime.count() / 1000.0f);
-		ImGui::Text("Mesh Queue Time: %.2f ms (Max: %.2f ms)", profilingInfo.meshQueueTime.count() / 1000.0f, profilingInfo.maxMeshQueueTime.count() / 1000.0f);
 		ImGui::Text("Chunk Generation Time: %.2f ms (Max: %.2f ms)", profilingInfo.chunkGenTime.count() / 1000.0f, profilingInfo.maxChunkGenTime.count() / 1000.0f);
 		ImGui::Text("World Draw Time: %.2f ms (Max: %.2f ms)", profilingInfo.worldDrawTime.count() / 1000.0f, profilingInfo.maxWorldDrawTime.count() / 1000.0f);
 		ImGui::Text("Total Render Time: %.2f ms (Max: %.2f ms)", profilingInfo.renderTime.count() / 1000.0f, profilingInfo.maxRenderTime.count() / 1000.0f);
+
+		const UniformStats uniformStats = Shader::getUniformStats();
+		ImGui::Text("Uniform Calls: %zu (By Name: %zu)", uniformStats.calls, uniformStats.lookups);
+	}
+
+	if (ImGui::CollapsingHeader("World Edits")) {
+		ImGui::SliderInt("Sphere Radius", &editRadius, 1, 16);
+
+		ImGui::Checkbox("Snap To Chunk Corner", &editAtChunkCorner);
+
+		// Centered far enough ahead that the camera isn't inside it, snapping spans four chunks so they're remeshed as a batch
+		glm::ivec3 editCenter = glm::ivec3(glm::floor(cameraPos + cameraFront * float(editRadius * 2 + 2)));
+		if (editAtChunkCorner) {
+			editCenter.x = static_cast<int>(std::round(editCenter.x / float(CHUNK_SIZE))) * CHUNK_SIZE;
+			editCenter.z = static_cast<int>(std::round(editCenter.z / float(CHUNK_SIZE))) * CHUNK_SIZE;
+		}
+
+		if (ImGui::Button("Dig Sphere")) {
+			world->fillSphere(editCenter, editRadius, VoxelType::EMPTY);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Place Sphere")) {
+			world->fillSphere(editCenter, editRadius, VoxelType::STONE);
+		}
+
+		const EditBatchStats batchStats = world->getEditBatchStats();
+		ImGui::Text("Batches Released: %llu (Timed Out: %llu)", static_cast<unsigned long long>(batchStats.released), static_cast<unsigned long long>(batchStats.timedOut));
+		ImGui::Text("Held Uploads: %llu", static_cast<unsigned long long>(batchStats.heldUploads));
+
+		const EditLatencyStats editStats = world->getEditLatencyStats();
+		ImGui::Text("Edits: %llu (Timed Out: %llu)", static_cast<unsigned long long>(editStats.count), static_cast<unsigned long long>(editStats.timedOut));
+		ImGui::Text("Edit To Visible: %.2f ms (Avg: %.2f ms, Max: %.2f ms)", editStats.last.count() / 1000.0f, editStats.average.count() / 1000.0f, editStats.max.count() / 1000.0f);
+	}
+
+	if (ImGui::CollapsingHeader("Chunk Memory")) {
+		const int chunkCount = world->getChunkCount();
+		const float voxelMemoryKiB = world->getVoxelMemoryUsage() / 1024.0f;
+		const float denseChunkKiB = (MAX_VOXELS * sizeof(Voxel)) / 1024.0f;
+
+		ImGui::Text("Voxel Memory: %.2f MiB", voxelMemoryKiB / 1024.0f);
+		ImGui::Text("Per Chunk: %.2f KiB (Dense: %.2f KiB)", chunkCount > 0 ? voxelMemoryKiB / chunkCount : 0.0f, denseChunkKiB);
+
+		// 0 follows the working set
+		int memoryBudgetMiB = static_cast<int>(world->getMemoryBudget() / (1024 * 1024));
+		if (ImGui::SliderInt("Memory Budget (MiB)", &memoryBudgetMiB, 0, 8192, memoryBudgetMiB == 0 ? "Working Set" : "%d")) {
+			world->setMemoryBudget(static_cast<size_t>(memoryBudgetMiB) * 1024 * 1024);
+		}
+
+		ImGui::Text("Resident: %.2f / %.2f MiB", world->getResidentBytes() / (1024.0f * 1024.0f), world->getEffectiveMemoryBudget() / (1024.0f * 1024.0f));
+		ImGui::Text("Evicted: %llu (Displaced: %llu)", static_cast<unsigned long long>(world->getEvictedCount()), static_cast<unsigned long long>(world->getDisplacedCount()));
+		ImGui::Text("Pending Mesh Deletions: %zu", facePool->getDeferredFreeCount());
+		ImGui::Text("Face Pool: %.2f / %.2f MiB (Free Blocks: %zu)", facePool->getAllocatedFaces() * sizeof(Face) / (1024.0f * 1024.0f), facePool->getCapacity() * sizeof(Face) / (1024.0f * 1024.0f), facePool->getFreeBlockCount());
+
+		const ChunkPoolStats poolStats = world->getChunkPoolStats();
+		ImGui::Text("Pooled Chunks: %zu (Allocated: %llu, Reused: %llu)", poolStats.pooled, static_cast<unsigned long long>(poolStats.allocated), static_cast<unsigned long long>(poolStats.reused));
+	}
+
+	if (ImGui::CollapsingHeader("Job System")) {
+		const auto showWorkStats = [](const ChunkWorkStats& workStats) {
+			ImGui::Text("  Useful: %llu, Cancelled: %llu", static_cast<unsigned long long>(workStats.useful), static_cast<unsigned long long>(workStats.cancelled));
+			ImGui::Text("  Wasted: %llu (Aborted: %llu, Discarded: %llu)",
+				static_cast<unsigned long long>(workStats.aborted + workStats.discarded),
+				static_cast<unsigned long long>(workStats.aborted),
+				static_cast<unsigned long long>(workStats.discarded));
+		};
+
+		const JobSystemStats jobStats = world->getJobStats();
+		const JobTypeStats& generationStats = jobStats.types[static_cast<size_t>(JobType::Generation)];
+		const JobTypeStats& meshingStats = jobStats.types[static_cast<size_t>(JobType::Meshing)];
+
+		ImGui::Text("Workers: %d", jobStats.workerCount);
+		ImGui::Text("Queue Depth: %zu", jobStats.queueDepth);
+		ImGui::Text("Steals: %llu", static_cast<unsigned long long>(jobStats.stealCount));
+
+		ImGui::Text("Generation Jobs: %llu", static_cast<unsigned long long>(generationStats.completed));
+		ImGui::Text("  Wait: %.2f ms (Max: %.2f ms)", generationStats.averageWaitTime.count() / 1000.0f, generationStats.maxWaitTime.count() / 1000.0f);
+		ImGui::Text("  Run: %.2f ms (Max: %.2f ms)", generationStats.averageRunTime.count() / 1000.0f, generationStats.maxRunTime.count() / 1000.0f);
+		showWorkStats(world->getWorkStats(JobType::Generation));
+
+		ImGui::Text("Meshing Jobs: %llu", static_cast<unsigned long long>(meshingStats.completed));
+		ImGui::Text("  Wait: %.2f ms (Max: %.2f ms)", meshingStats.averageWaitTime.count() / 1000.0f, meshingStats.maxWaitTime.count() / 1000.0f);
+		ImGui::Text("  Run: %.2f ms (Max: %.2f ms)", meshingStats.averageRunTime.count() / 1000.0f, meshingStats.maxRunTime.count() / 1000.0f);
+		showWorkStats(world->getWorkStats(JobType::Meshing));
+	}
+
+	if (ImGui::CollapsingHeader("SIMD Kernels")) {
+		ImGui::Text("Supported: %s", Simd::getLevelName(Simd::getLevel()));
+
+		// Blocks the frame for a few milliseconds
+		if (ImGui::Button("Run Benchmark")) {
+			simdBenchmarkResults = Benchmark::runSimd();
+		}
+
+		for (const Benchmark::SimdResult& result : simdBenchmarkResults) {
+			const Benchmark::SimdResult& scalar = simdBenchmarkResults.front();
+			const float maskMicros = result.maskTime.count() / 1000.0f;
+			const float terrainMicros = result.terrainTime.count() / 1000.0f;
+
+			ImGui::Text("%s: Masks %.1f us (%.1fx), Terrain %.1f us (%.1fx)", Simd::getLevelName(result.level),
+				maskMicros, scalar.maskTime.count() / std::max(1.0f, float(result.maskTime.count())),
+				terrainMicros, scalar.terrainTime.count() / std::max(1.0f, float(result.terrainTime.count())));
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Greedy Meshing")) {
+		// Generates and meshes a block of Advanced chunks, blocks the frame for a while
+		if (ImGui::Button("Run Meshing Benchmark")) {
+			meshingBenchmarkResult = Benchmark::runMeshing();
+		}
+
+		const Benchmark::MeshingResult& result = meshingBenchmarkResult;
+		if (result.chunkCount > 0) {
+			const float faceReduction = result.unmergedFaces > 0 ? 100.0f * (1.0f - float(result.faces) / float(result.unmergedFaces)) : 0.0f;
+
+			ImGui::Text("Chunks: %d (Advanced, Mesh Time: %.2f ms)", result.chunkCount, result.meshTime.count() / 1000000.0f);
+			ImGui::Text("Faces: %zu (Unmerged: %zu, -%.1f%%)", result.faces, result.unmergedFaces, faceReduction);
+			ImGui::Text("Vertices: %zu (Unmerged: %zu)", result.faces * 4, result.unmergedFaces * 4);
+		}
 	}
 
 	if (ImGui::CollapsingHeader("SSAO Settings")) {
@@ -8,11 +8,13 @@
 #include "shader.h"
 #include "renderer.h"
 #include "textureAtlas.h"
+#include "benchmark.h"
 #include <vector>
 #include <memory>
 #include <chrono>
 
 class World;
+class FacePool;
 class Cube;
 class CubeMap;
 
@@ -28,13 +30,11 @@ struct MovementState {
 
 struct ProfilingInfo {
 	std::chrono::microseconds chunkQueueTime = std::chrono::microseconds(0);
-	std::chrono::microseconds meshQueueTime = std::chrono::microseconds(0);
 	std::chrono::microseconds chunkGenTime = std::chrono::microseconds(0);
 	std::chrono::microseconds worldDrawTime = std::chrono::microseconds(0);
 	std::chrono::microseconds renderTime = std::chrono::microseconds(0);
 
 	std::chrono::microseconds maxChunkQueueTime = std::chrono::microseconds(0);
-	std::chrono::microseconds maxMeshQueueTime = std::chrono::microseconds(0);
 	std::chrono::microseconds maxChunkGenTime = std::chrono::microseconds(0);
 	std::chrono::microseconds maxWorldDrawTime = std::chrono::microseconds(0);
 	std::chrono::microseconds maxRenderTime = std::chrono::microseconds(0);
@@ -52,6 +52,8 @@ public:
 	void exit() override;
 
 private:
+	// Declared before the world so every chunk mesh is gone before the pool
+	std::unique_ptr<FacePool> facePool;
 	std::unique_ptr<World> world;
 	std::unique_ptr<Cube> cube;
 	std::unique_ptr<CubeMap> skybox;
@@ -64,11 +66,14 @@ private:
 	Shader& shaderForward;
 	Shader& shaderWater;
 	Shader& shaderSkybox;
+	Shader& shaderCull;
 	SceneManager& sceneManager;
 	ShaderManager& shaderManager;
 	InputManager& inputManager;
 
 	ProfilingInfo profilingInfo;
+	std::vector<Benchmark::SimdResult> simdBenchmarkResults;
+	Benchmark::MeshingResult meshingBenchmarkResult;
 
 	std::vector<CallbackHandle> inputCallbackHandles;
 
@@ -116,15 +121,19 @@ private:
 	int renderDistance = 12;
 	float speedMultiplier = 1.0f;
 
+	// Sphere edits placed in front of the camera from the debug UI
+	int editRadius = 4;
+	bool editAtChunkCorner = false;
+
 	bool cameraMovementDisabled = false;
 	bool exitSceneRequested = false;
 
 	void updateCamera(float deltaTime);
 
-	void renderGeometry(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
+	void renderGeometry(Renderer& renderer);
 	void renderLit(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection, const Material worldMaterial);
 	void renderUnlit(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
-	void renderExtras(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
+	void renderExtras(Renderer& renderer);
 	void renderSkybox(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
-	void renderWater(Renderer& renderer, const glm::mat4& view, const glm::mat4& projection);
+	void renderWater(Renderer& renderer);
 };
\ No newline at end of file
@@ -32,7 +32,8 @@ Shader::Shader(const std::string& vertexShaderPath, const std::string& fragmentS
 		throw std::runtime_error("Failed to compile shaders");
 	}
 
-	programID = linkProgram(vertexShader, fragmentShader);
+	const GLuint shaderIDs[] = { vertexShader, fragmentShader };
+	programID = linkProgram(shaderIDs);
 
 	// Delete shaders after linking
 	glDeleteShader(vertexShader);
@@ -42,6 +43,31 @@ Shader::Shader(const std::string& vertexShaderPath, const std::string& fragmentS
 	if (programID == 0) {
 		throw std::runtime_error("Failed to link shader program");
 	}
+
+	loadUniformLocations();
+	resolveLightUniforms();
+}
+
+Shader::Shader(const std::string& computeShaderPath) {
+	GLuint computeShader = compileShader(computeShaderPath.c_str(), GL_COMPUTE_SHADER);
+
+	if (computeShader == 0) {
+		programID = 0;
+		throw std::runtime_error("Failed to compile shaders");
+	}
+
+	const GLuint shaderIDs[] = { computeShader };
+	programID = linkProgram(shaderIDs);
+
+	// Delete shader after linking
+	glDeleteShader(computeShader);
+
+	// Check if program linking was successful
+	if (programID == 0) {
+		throw std::runtime_error("Failed to link shader program");
+	}
+
+	loadUniformLocations();
 }
 
 Shader::~Shader() {
@@ -52,112 +78,218 @@ void Shader::use() const {
 	glUseProgram(programID);
 }
 
-// Uniform setting
-void Shader::setUniform(const std::string& name, int value) const {
-	GLint location = glGetUniformLocation(programID, name.c_str());
+// Uniform lookup
+UniformHandle Shader::getUniform(std::string_view name) const {
+	auto it = uniformLocations.find(name);
 
-	if (location == -1) {
+	if (it == uniformLocations.end()) {
 		//std::cerr << "Warning: Uniform '" << name << "' not found in shader program." << std::endl;
-		return;
+		return {};
 	}
 
-	glUniform1i(location, value);
+	return { it->second };
 }
 
-void Shader::setUniform(const std::string& name, float value) const {
-	GLint location = glGetUniformLocation(programID, name.c_str());
+void Shader::resetUniformStats() {
+	lastUniformStats = uniformStats;
+	uniformStats = {};
+}
 
-	if (location == -1) {
-		//std::cerr << "Warning: Uniform '" << name << "' not found in shader program." << std::endl;
+// Uniform setting
+void Shader::setUniform(const UniformHandle handle, int value) const {
+	if (!handle.isValid()) {
 		return;
 	}
 
-	glUniform1f(location, value);
+	uniformStats.calls++;
+	glUniform1i(handle.location, value);
 }
 
-void Shader::setUniform(const std::string& name, const glm::vec2& value) const {
-	GLint location = glGetUniformLocation(programID, name.c_str());
-
-	if (location == -1) {
-		//std::cerr << "Warning: Uniform '" << name << "' not found in shader program." << std::endl;
+void Shader::setUniform(const UniformHandle handle, float value) const {
+	if (!handle.isValid()) {
 		return;
 	}
 
-	glUniform2fv(location, 1, &value[0]);
+	uniformStats.calls++;
+	glUniform1f(handle.location, value);
 }
 
-void Shader::setUniform(const std::string& name, const glm::vec3& value) const {
-	GLint location = glGetUniformLocation(programID, name.c_str());
-
-	if (location == -1) {
-		//std::cerr << "Warning: Uniform '" << name << "' not found in shader program." << std::endl;
+void Shader::setUniform(const UniformHandle handle, const glm::vec2& value) const {
+	if (!handle.isValid()) {
 		return;
 	}
 
-	glUniform3fv(location, 1, &value[0]);
+	uniformStats.calls++;
+	glUniform2fv(handle.location, 1, &value[0]);
 }
 
-void Shader::setUniform(const std::string& name, const glm::vec4& value) const {
-	GLint location = glGetUniformLocation(programID, name.c_str());
+void Shader::setUniform(const UniformHandle handle, const glm::ivec2& value) const {
+	if (!handle.isValid()) {
+		return;
+	}
 
-	if (location == -1) {
-		//std::cerr << "Warning: Uniform '" << name << "' not found in shader program." << std::endl;
+	uniformStats.calls++;
+	glUniform2iv(handle.location, 1, &value[0]);
+}
+
+void Shader::setUniform(const UniformHandle handle, const glm::vec3& value) const {
+	if (!handle.isValid()) {
 		return;
 	}
 
-	glUniform4fv(location, 1, &value[0]);
+	uniformStats.calls++;
+	glUniform3fv(handle.location, 1, &value[0]);
 }
 
-void Shader::setUniform(const std::string& name, const glm::mat3& value) const {
-	GLint location = glGetUniformLocation(programID, name.c_str());
+void Shader::setUniform(const UniformHandle handle, const glm::vec4& value) const {
+	if (!handle.isValid()) {
+		return;
+	}
 
-	if (location == -1) {
-		//std::cerr << "Warning: Uniform '" << name << "' not found in shader program." << std::endl;
+	uniformStats.calls++;
+	glUniform4fv(handle.location, 1, &value[0]);
+}
+
+void Shader::setUniform(const UniformHandle handle, const glm::mat3& value) const {
+	if (!handle.isValid()) {
 		return;
 	}
 
-	glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	uniformStats.calls++;
+	glUniformMatrix3fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void Shader::setUniform(const std::string& name, const glm::mat4& value) const {
-	GLint location = glGetUniformLocation(programID, name.c_str());
+void Shader::setUniform(const UniformHandle handle, const glm::mat4& value) const {
+	if (!handle.isValid()) {
+		return;
+	}
+
+	uniformStats.calls++;
+	glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(value));
+}
 
-	if (location == -1) {
-		//std::cerr << "Warning: Uniform '" << name << "' not found in shader program." << std::endl;
+// Array elements have consecutive locations, so a whole array goes up in one call
+void Shader::setUniform(const UniformHandle handle, std::span<const glm::vec3> values) const {
+	if (!handle.isValid() || values.empty()) {
 		return;
 	}
 
-	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	uniformStats.calls++;
+	glUniform3fv(handle.location, static_cast<GLsizei>(values.size()), glm::value_ptr(values[0]));
 }
 
 void Shader::setUniforms(const DirectLight& light) const {
-	setUniform("directLight.direction", light.direction);
-	setUniform("directLight.ambient", light.ambient);
-	setUniform("directLight.diffuse", light.diffuse);
-	setUniform("directLight.specular", light.specular);
+	setUniform(directLightUniforms.direction, light.direction);
+	setUniform(directLightUniforms.ambient, light.ambient);
+	setUniform(directLightUniforms.diffuse, light.diffuse);
+	setUniform(directLightUniforms.specular, light.specular);
 }
 
 void Shader::setUniforms(const PointLight& light, const int index) const {
-	setUniform(std::format("pointLights[{}].position", index), light.position);
-	setUniform(std::format("pointLights[{}].constant", index), light.constant);
-	setUniform(std::format("pointLights[{}].linear", index), light.linear);
-	setUniform(std::format("pointLights[{}].quadratic", index), light.quadratic);
-	setUniform(std::format("pointLights[{}].ambient", index), light.ambient);
-	setUniform(std::format("pointLights[{}].diffuse", index), light.diffuse);
-	setUniform(std::format("pointLights[{}].specular", index), light.specular);
+	if (index < 0 || index >= static_cast<int>(pointLightUniforms.size())) {
+		return;
+	}
+
+	const PointLightUniforms& uniforms = pointLightUniforms[index];
+	setUniform(uniforms.position, light.position);
+	setUniform(uniforms.constant, light.constant);
+	setUniform(uniforms.linear, light.linear);
+	setUniform(uniforms.quadratic, light.quadratic);
+	setUniform(uniforms.ambient, light.ambient);
+	setUniform(uniforms.diffuse, light.diffuse);
+	setUniform(uniforms.specular, light.specular);
 }
 
 void Shader::setUniforms(const SpotLight& light, const int index) const {
-	setUniform(std::format("spotLights[{}].position", index), light.position);
-	setUniform(std::format("spotLights[{}].direction", index), light.direction);
-	setUniform(std::format("spotLights[{}].cutOff", index), light.cutOff);
-	setUniform(std::format("spotLights[{}].outerCutOff", index), light.outerCutOff);
-	setUniform(std::format("spotLights[{}].constant", index), light.constant);
-	setUniform(std::format("spotLights[{}].linear", index), light.linear);
-	setUniform(std::format("spotLights[{}].quadratic", index), light.quadratic);
-	setUniform(std::format("spotLights[{}].ambient", index), light.ambient);
-	setUniform(std::format("spotLights[{}].diffuse", index), light.diffuse);
-	setUniform(std::format("spotLights[{}].specular", index), light.specular);
+	if (index < 0 || index >= static_cast<int>(spotLightUniforms.size())) {
+		return;
+	}
+
+	const SpotLightUniforms& uniforms = spotLightUniforms[index];
+	setUniform(uniforms.position, light.position);
+	setUniform(uniforms.direction, light.direction);
+	setUniform(uniforms.cutOff, light.cutOff);
+	setUniform(uniforms.outerCutOff, light.outerCutOff);
+	setUniform(uniforms.constant, light.constant);
+	setUniform(uniforms.linear, light.linear);
+	setUniform(uniforms.quadratic, light.quadratic);
+	setUniform(uniforms.ambient, light.ambient);
+	setUniform(uniforms.diffuse, light.diffuse);
+	setUniform(uniforms.specular, light.specular);
+}
+
+// Introspection
+void Shader::loadUniformLocations() {
+	GLint uniformCount = 0;
+	glGetProgramInterfaceiv(programID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+
+	const GLenum properties[] = { GL_NAME_LENGTH, GL_LOCATION, GL_ARRAY_SIZE };
+	std::string name;
+
+	for (GLint i = 0; i < uniformCount; i++) {
+		GLint values[3] = {};
+		glGetProgramResourceiv(programID, GL_UNIFORM, i, 3, properties, 3, nullptr, values);
+
+		// Uniform block members have no location
+		const GLint location = values[1];
+		if (location == -1) {
+			continue;
+		}
+
+		name.resize(values[0]);
+		glGetProgramResourceName(programID, GL_UNIFORM, i, values[0], nullptr, name.data());
+		name.resize(values[0] - 1);
+
+		uniformLocations.emplace(name, location);
+
+		// Arrays are reported as "name[0]", register the bare name and every element
+		const GLint arraySize = values[2];
+		if (arraySize > 1 && name.ends_with("[0]")) {
+			const std::string baseName = name.substr(0, name.size() - 3);
+			uniformLocations.emplace(baseName, location);
+
+			for (GLint element = 1; element < arraySize; element++) {
+				uniformLocations.emplace(std::format("{}[{}]", baseName, element), location + element);
+			}
+		}
+	}
+}
+
+// Light struct arrays are resolved up front, setUniforms then never builds names
+void Shader::resolveLightUniforms() {
+	directLightUniforms = {
+		getUniform("directLight.direction"),
+		getUniform("directLight.ambient"),
+		getUniform("directLight.diffuse"),
+		getUniform("directLight.specular")
+	};
+
+	for (int i = 0; getUniform(std::format("pointLights[{}].position", i)).isValid(); i++) {
+		pointLightUniforms.push_back({
+			getUniform(std::format("pointLights[{}].position", i)),
+			getUniform(std::format("pointLights[{}].constant", i)),
+			getUniform(std::format("pointLights[{}].linear", i)),
+			getUniform(std::format("pointLights[{}].quadratic", i)),
+			getUniform(std::format("pointLights[{}].ambient", i)),
+			getUniform(std::format("pointLights[{}].diffuse", i)),
+			getUniform(std::format("pointLights[{}].specular", i))
+		});
+	}
+
+	for (int i = 0; getUniform(std::format("spotLights[{}].position", i)).isValid(); i++) {
+		spotLightUniforms.push_back({
+			getUniform(std::format("spotLights[{}].position", i)),
+			getUniform(std::format("spotLights[{}].direction", i)),
+			getUniform(std::format("spotLights[{}].cutOff", i)),
+			getUniform(std::format("spotLights[{}].outerCutOff", i)),
+			getUniform(std::format("spotLights[{}].constant", i)),
+			getUniform(std::format("spotLights[{}].linear", i)),
+			getUniform(std::format("spotLights[{}].quadratic", i)),
+			getUniform(std::format("spotLights[{}].ambient", i)),
+			getUniform(std::format("spotLights[{}].diffuse", i)),
+			getUniform(std::format("spotLights[{}].specular", i))
+		});
+	}
 }
 
 // Complilation and linking
@@ -207,13 +339,14 @@ GLuint Shader::compileShader(const char* shaderPath, GLenum shaderType) {
 	return ShaderID;
 }
 
-GLuint Shader::linkProgram(GLuint vertexShaderID, GLuint fragmentShaderID) {
+GLuint Shader::linkProgram(std::span<const GLuint> shaderIDs) {
 	// Link the program
 	std::cout << "Linking shader program" << std::endl;
 
 	GLuint ProgramID = glCreateProgram();
-	glAttachShader(ProgramID, vertexShaderID);
-	glAttachShader(ProgramID, fragmentShaderID);
+	for (const GLuint shaderID : shaderIDs) {
+		glAttachShader(ProgramID, shaderID);
+	}
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -236,8 +369,9 @@ GLuint Shader::linkProgram(GLuint vertexShaderID, GLuint fragmentShaderID) {
 	}
 
 	// Detach shaders after linking
-	glDetachShader(ProgramID, vertexShaderID);
-	glDetachShader(ProgramID, fragmentShaderID);
+	for (const GLuint shaderID : shaderIDs) {
+		glDetachShader(ProgramID, shaderID);
+	}
 
 	std::cout << "Shader program linked successfully" << std::endl;
 	return ProgramID;
@@ -3,25 +3,55 @@
 #include "structs.h"
 #include <glad/glad.h>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <span>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/mat3x3.hpp>
 #include <glm/mat4x4.hpp>
 
+// Resolved uniform location, invalid handles are ignored by the setters
+struct UniformHandle {
+	GLint location = -1;
+
+	bool isValid() const { return location != -1; }
+};
+
+// Uniform traffic of the last frame, lookups are the by-name setter calls
+struct UniformStats {
+	size_t calls = 0;
+	size_t lookups = 0;
+};
+
 class Shader {
 public:
 	Shader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+	Shader(const std::string& computeShaderSource);
 	~Shader();
 
 	void use() const;
-	void setUniform(const std::string& name, int value) const;
-	void setUniform(const std::string& name, float value) const;
-	void setUniform(const std::string& name, const glm::vec2& value) const;
-	void setUniform(const std::string& name, const glm::vec3& value) const;
-	void setUniform(const std::string& name, const glm::vec4& value) const;
-	void setUniform(const std::string& name, const glm::mat3& value) const;
-	void setUniform(const std::string& name, const glm::mat4& value) const;
+
+	// Location table filled at link time, resolve once and keep the handle on hot paths
+	UniformHandle getUniform(std::string_view name) const;
+
+	void setUniform(const UniformHandle handle, int value) const;
+	void setUniform(const UniformHandle handle, float value) const;
+	void setUniform(const UniformHandle handle, const glm::vec2& value) const;
+	void setUniform(const UniformHandle handle, const glm::ivec2& value) const;
+	void setUniform(const UniformHandle handle, const glm::vec3& value) const;
+	void setUniform(const UniformHandle handle, const glm::vec4& value) const;
+	void setUniform(const UniformHandle handle, const glm::mat3& value) const;
+	void setUniform(const UniformHandle handle, const glm::mat4& value) const;
+	void setUniform(const UniformHandle handle, std::span<const glm::vec3> values) const;
+
+	template <typename T>
+	void setUniform(std::string_view name, const T& value) const {
+		uniformStats.lookups++;
+		setUniform(getUniform(name), value);
+	}
 
 	void setUniforms(const DirectLight& light) const;
 	void setUniforms(const PointLight& light, const int index) const;
@@ -31,9 +61,44 @@ public:
 		return programID;
 	};
 
+	// Rolls the per-frame counters over, called once at the start of every frame
+	static void resetUniformStats();
+	static UniformStats getUniformStats() { return lastUniformStats; }
+
 private:
 	GLuint programID;
 
+	// Allows lookups by string_view without building a std::string
+	struct NameHash {
+		using is_transparent = void;
+		size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+	};
+
+	std::unordered_map<std::string, GLint, NameHash, std::equal_to<>> uniformLocations;
+
+	struct DirectLightUniforms {
+		UniformHandle direction, ambient, diffuse, specular;
+	};
+
+	struct PointLightUniforms {
+		UniformHandle position, constant, linear, quadratic, ambient, diffuse, specular;
+	};
+
+	struct SpotLightUniforms {
+		UniformHandle position, direction, cutOff, outerCutOff, constant, linear, quadratic, ambient, diffuse, specular;
+	};
+
+	DirectLightUniforms directLightUniforms;
+	std::vector<PointLightUniforms> pointLightUniforms;
+	std::vector<SpotLightUniforms> spotLightUniforms;
+
+	// Render thread only
+	static inline UniformStats uniformStats;
+	static inline UniformStats lastUniformStats;
+
+	void loadUniformLocations();
+	void resolveLightUniforms();
+
 	GLuint compileShader(const char* shaderSource, GLenum shaderType);
-	GLuint linkProgram(GLuint vertexShaderID, GLuint fragmentShaderID);
+	GLuint linkProgram(std::span<const GLuint> shaderIDs);
 };
\ No newline at end of file
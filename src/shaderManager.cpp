@@ -18,6 +18,21 @@ Shader& ShaderManager::get(const std::string& vertexShaderPath, const std::strin
 	return load(key, vertexShaderPath, fragmentShaderPath);
 }
 
+Shader& ShaderManager::get(const std::string& computeShaderPath) {
+	std::cout << "Attempting to load shader: " << computeShaderPath << std::endl;
+
+	// Return existing one if possible
+	Shader* existingShader = retrieve(computeShaderPath);
+
+	if (existingShader != nullptr) {
+		std::cout << "Shader found in cache" << std::endl << std::endl;
+		return *existingShader;
+	}
+
+	// Create new one if not found
+	return load(computeShaderPath, computeShaderPath);
+}
+
 // Loads a shader from source code and caches it
 Shader& ShaderManager::load(const std::string& key, const std::string& vertexShaderPath, const std::string& fragmentShaderPath) {
 	try {
@@ -33,6 +48,20 @@ Shader& ShaderManager::load(const std::string& key, const std::string& vertexSha
 	}
 }
 
+Shader& ShaderManager::load(const std::string& key, const std::string& computeShaderPath) {
+	try {
+		std::unique_ptr<Shader> shader = std::make_unique<Shader>(computeShaderPath);
+		shaders[key] = std::move(shader);
+
+		std::cout << "Shader loaded and cached" << std::endl << std::endl;
+		return *shaders[key];
+	}
+	catch (const std::exception& error) {
+		std::cerr << "Failed to load shader: " << error.what() << std::endl;
+		throw;
+	}
+}
+
 // Retrieves a shader from the cache by key
 Shader* ShaderManager::retrieve(const std::string& key) {
 	auto iterator = shaders.find(key);
@@ -9,9 +9,11 @@
 class ShaderManager {
 public:
 	Shader& get(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	Shader& get(const std::string& computeShaderPath);
 
 private:
 	Shader& load(const std::string& key, const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	Shader& load(const std::string& key, const std::string& computeShaderPath);
 	Shader* retrieve(const std::string& key);
 
 	std::unordered_map<std::string, std::unique_ptr<Shader>> shaders;
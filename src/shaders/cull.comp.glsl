@@ -0,0 +1,158 @@
+#version 460 core
+layout (local_size_x = 64) in;
+
+struct DrawCommand {
+	uint count;
+	uint instanceCount;
+	uint first;
+	uint baseInstance;
+};
+
+struct ChunkCullInput {
+	vec4 boundsMin;
+	vec4 boundsMax;
+	DrawCommand opaque;
+	DrawCommand liquid;
+};
+
+layout (std140, binding = 0) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 inverseView;
+	mat4 inverseProjection;
+	vec4 cameraPosition;
+};
+
+layout (std430, binding = 2) readonly buffer CullInputs {
+	ChunkCullInput inputs[];
+};
+
+layout (std430, binding = 3) writeonly buffer OpaqueCommands {
+	DrawCommand opaqueCommands[];
+};
+
+layout (std430, binding = 4) writeonly buffer OpaqueOffsets {
+	vec4 opaqueOffsets[];
+};
+
+layout (std430, binding = 5) writeonly buffer LiquidCommands {
+	DrawCommand liquidCommands[];
+};
+
+layout (std430, binding = 6) writeonly buffer LiquidOffsets {
+	vec4 liquidOffsets[];
+};
+
+layout (std430, binding = 7) buffer DrawCounts {
+	uint opaqueCount;
+	uint liquidCount;
+	uint frustumCulledCount;
+	uint occlusionCulledCount;
+};
+
+uniform int inputCount;
+
+// Hi-Z pyramid of the last frame's depth and the matrix it was rendered with
+uniform sampler2D hiZ;
+uniform int hiZValid;
+uniform int occlusionEnabled;
+uniform ivec2 hiZSize;
+uniform int hiZLevels;
+uniform mat4 hiZViewProjection;
+
+// Outside if the corner furthest along the plane normal is behind it
+bool isVisible(vec3 boundsMin, vec3 boundsMax) {
+	mat4 vpt = transpose(viewProjection);
+	vec4 planes[6] = vec4[6](
+		vpt[3] + vpt[0],
+		vpt[3] - vpt[0],
+		vpt[3] + vpt[1],
+		vpt[3] - vpt[1],
+		vpt[3] + vpt[2],
+		vpt[3] - vpt[2]
+	);
+
+	for (int i = 0; i < 6; i++) {
+		vec3 corner = mix(boundsMin, boundsMax, greaterThanEqual(planes[i].xyz, vec3(0.0)));
+		if (dot(planes[i].xyz, corner) + planes[i].w < 0.0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Hidden if the box's nearest depth is behind the farthest depth over its screen rect
+bool isOccluded(vec3 boundsMin, vec3 boundsMax) {
+	vec2 uvMin = vec2(1.0);
+	vec2 uvMax = vec2(0.0);
+	float nearestDepth = 1.0;
+
+	for (int i = 0; i < 8; i++) {
+		vec3 corner = mix(boundsMin, boundsMax, bvec3((i & 1) != 0, (i & 2) != 0, (i & 4) != 0));
+		vec4 clip = hiZViewProjection * vec4(corner, 1.0);
+
+		// Crossing the camera plane, can't be bounded on screen
+		if (clip.w <= 0.0) {
+			return false;
+		}
+
+		vec3 ndc = clip.xyz / clip.w;
+		uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+		uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+		nearestDepth = min(nearestDepth, ndc.z * 0.5 + 0.5);
+	}
+
+	uvMin = clamp(uvMin, 0.0, 1.0);
+	uvMax = clamp(uvMax, 0.0, 1.0);
+
+	// Level where the rect spans at most 2x2 texels
+	vec2 extent = (uvMax - uvMin) * vec2(hiZSize);
+	int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, hiZLevels - 1);
+
+	ivec2 levelSize = max(hiZSize >> level, ivec2(1));
+	ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+	ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+	float farthest = max(
+		max(texelFetch(hiZ, texelMin, level).r, texelFetch(hiZ, ivec2(texelMax.x, texelMin.y), level).r),
+		max(texelFetch(hiZ, ivec2(texelMin.x, texelMax.y), level).r, texelFetch(hiZ, texelMax, level).r)
+	);
+
+	return nearestDepth > farthest;
+}
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= uint(inputCount)) {
+		return;
+	}
+
+	ChunkCullInput chunk = inputs[index];
+	if (!isVisible(chunk.boundsMin.xyz, chunk.boundsMax.xyz)) {
+		atomicAdd(frustumCulledCount, 1);
+		return;
+	}
+
+	if (occlusionEnabled != 0 && hiZValid != 0 && isOccluded(chunk.boundsMin.xyz, chunk.boundsMax.xyz)) {
+		atomicAdd(occlusionCulledCount, 1);
+		return;
+	}
+
+	// Chunk meshes are only translated in x and z
+	vec4 offset = vec4(chunk.boundsMin.x, 0.0, chunk.boundsMin.z, 0.0);
+
+	if (chunk.opaque.instanceCount > 0) {
+		uint slot = atomicAdd(opaqueCount, 1);
+		opaqueCommands[slot] = chunk.opaque;
+		opaqueOffsets[slot] = offset;
+	}
+
+	if (chunk.liquid.instanceCount > 0) {
+		uint slot = atomicAdd(liquidCount, 1);
+		liquidCommands[slot] = chunk.liquid;
+		liquidOffsets[slot] = offset;
+	}
+}
\ No newline at end of file
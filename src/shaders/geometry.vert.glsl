@@ -6,28 +6,41 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec3 VertexColor;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 inverseView;
+	mat4 inverseProjection;
+	vec4 cameraPosition;
+};
+
+// World offset of each chunk, one per multi-draw command
+layout (std430, binding = 1) readonly buffer ChunkOffsets {
+	vec4 chunkOffsets[];
+};
 
 uniform sampler2DArray textureArray;
-uniform mat3 normal;
 
-const uint POS_BITS = 6;
-const uint POS_Y_BITS = 8;
+const uint POS_BITS = 5;
+const uint POS_Y_BITS = 7;
 const uint FACE_BITS = 3;
-const uint TEX_BITS = 9;
+const uint TEX_BITS = 4;
+const uint SIZE_BITS = 4;
 
 const uint X_SHIFT = 0;
 const uint Y_SHIFT = POS_BITS;
 const uint Z_SHIFT = Y_SHIFT + POS_Y_BITS;
 const uint FACE_SHIFT = Z_SHIFT + POS_BITS;
 const uint TEX_SHIFT = FACE_SHIFT + FACE_BITS;
+const uint WIDTH_SHIFT = TEX_SHIFT + TEX_BITS;
+const uint HEIGHT_SHIFT = WIDTH_SHIFT + SIZE_BITS;
 
 const uint POSITION_MASK = (1 << POS_BITS) - 1;
 const uint POSITION_Y_MASK = (1 << POS_Y_BITS) - 1;
 const uint FACE_MASK = (1 << FACE_BITS) - 1;
 const uint TEX_MASK = (1 << TEX_BITS) - 1;
+const uint SIZE_MASK = (1 << SIZE_BITS) - 1;
 
 const vec3 faceNormals[6] = vec3[6](
 	vec3(1, 0, 0),
@@ -52,7 +65,7 @@ void main()
 	// Normal
 	uint face = ((packedFace >> FACE_SHIFT) & FACE_MASK);
 	vec3 aNorm = faceNormals[face];
-	Normal = normal * aNorm;
+	Normal = mat3(view) * aNorm;
 	
 	// Color
 	uint texID = ((packedFace >> TEX_SHIFT) & TEX_MASK);
@@ -65,10 +78,14 @@ void main()
 	chunkPos.y = float((packedFace >> Y_SHIFT) & POSITION_Y_MASK);
 	chunkPos.z = float((packedFace >> Z_SHIFT) & POSITION_MASK);
 
+	// Merged quads stretch from the anchor voxel over width x height voxels
+	vec2 size = vec2(float((packedFace >> WIDTH_SHIFT) & SIZE_MASK) + 1.0, float((packedFace >> HEIGHT_SHIFT) & SIZE_MASK) + 1.0);
+	vec3 sizeOffset = abs(faceRotations[face] * vec3(size - 1.0, 0.0)) * 0.5;
+
 	vec3 faceOffset = aNorm * 0.5;
-	vec3 aPos = faceRotations[face] * localPos + faceOffset + chunkPos;
+	vec3 aPos = faceRotations[face] * (localPos * vec3(size, 1.0)) + faceOffset + sizeOffset + chunkPos;
 
-	vec4 viewPos = view * model * vec4(aPos, 1.0);
+	vec4 viewPos = view * vec4(aPos + chunkOffsets[gl_DrawID].xyz, 1.0);
 	FragPos = viewPos.xyz;
 	
 	gl_Position = projection * viewPos;
@@ -0,0 +1,31 @@
+#version 460 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (r32f, binding = 0) uniform writeonly image2D target;
+
+// Depth buffer for the first level, the previous level after that
+uniform sampler2D source;
+uniform int sourceLevel;
+uniform ivec2 sourceSize;
+uniform ivec2 targetSize;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(texel, targetSize))) {
+		return;
+	}
+
+	// Farthest depth of the 2x2 footprint, odd sources fold their last row and column into the edge texels
+	ivec2 first = texel * 2;
+	ivec2 last = min(first + 1 + ivec2(equal(texel, targetSize - 1)) * (sourceSize & 1), sourceSize - 1);
+
+	float farthest = 0.0;
+	for (int y = first.y; y <= last.y; y++) {
+		for (int x = first.x; x <= last.x; x++) {
+			farthest = max(farthest, texelFetch(source, ivec2(x, y), sourceLevel).r);
+		}
+	}
+
+	imageStore(target, texel, vec4(farthest));
+}
\ No newline at end of file
@@ -4,27 +4,41 @@ layout (location = 1) in uint packedFace;
 
 out vec4 Albedo;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform Camera {
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 inverseView;
+	mat4 inverseProjection;
+	vec4 cameraPosition;
+};
+
+// World offset of each chunk, one per multi-draw command
+layout (std430, binding = 1) readonly buffer ChunkOffsets {
+	vec4 chunkOffsets[];
+};
 
 uniform sampler2DArray textureArray;
 
-const uint POS_BITS = 6;
-const uint POS_Y_BITS = 8;
+const uint POS_BITS = 5;
+const uint POS_Y_BITS = 7;
 const uint FACE_BITS = 3;
-const uint TEX_BITS = 9;
+const uint TEX_BITS = 4;
+const uint SIZE_BITS = 4;
 
 const uint X_SHIFT = 0;
 const uint Y_SHIFT = POS_BITS;
 const uint Z_SHIFT = Y_SHIFT + POS_Y_BITS;
 const uint FACE_SHIFT = Z_SHIFT + POS_BITS;
 const uint TEX_SHIFT = FACE_SHIFT + FACE_BITS;
+const uint WIDTH_SHIFT = TEX_SHIFT + TEX_BITS;
+const uint HEIGHT_SHIFT = WIDTH_SHIFT + SIZE_BITS;
 
 const uint POSITION_MASK = (1 << POS_BITS) - 1;
 const uint POSITION_Y_MASK = (1 << POS_Y_BITS) - 1;
 const uint FACE_MASK = (1 << FACE_BITS) - 1;
 const uint TEX_MASK = (1 << TEX_BITS) - 1;
+const uint SIZE_MASK = (1 << SIZE_BITS) - 1;
 
 const vec3 faceNormals[6] = vec3[6](
 	vec3(1, 0, 0),
@@ -60,8 +74,12 @@ void main()
 	chunkPos.y = float((packedFace >> Y_SHIFT) & POSITION_Y_MASK);
 	chunkPos.z = float((packedFace >> Z_SHIFT) & POSITION_MASK);
 
+	// Merged quads stretch from the anchor voxel over width x height voxels
+	vec2 size = vec2(float((packedFace >> WIDTH_SHIFT) & SIZE_MASK) + 1.0, float((packedFace >> HEIGHT_SHIFT) & SIZE_MASK) + 1.0);
+	vec3 sizeOffset = abs(faceRotations[face] * vec3(size - 1.0, 0.0)) * 0.5;
+
 	vec3 faceOffset = faceNormals[face] * 0.5;
-	vec3 worldLocalPos = faceRotations[face] * localPos + faceOffset + chunkPos;
+	vec3 worldLocalPos = faceRotations[face] * (localPos * vec3(size, 1.0)) + faceOffset + sizeOffset + chunkPos;
 	
-	gl_Position = projection * view * model * vec4(worldLocalPos, 1.0);
+	gl_Position = viewProjection * vec4(worldLocalPos + chunkOffsets[gl_DrawID].xyz, 1.0);
 }
\ No newline at end of file
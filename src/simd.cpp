@@ -0,0 +1,54 @@
+#include "simd.h"
+
+#if SIMD_X86 && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+	Simd::Level detectLevel() {
+#if !SIMD_X86
+		return Simd::Level::Scalar;
+#elif defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		const bool sse41 = (info[2] & (1 << 19)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+
+		// The OS has to save the YMM registers too
+		bool avx2 = false;
+		if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		return avx2 ? Simd::Level::AVX2 : (sse41 ? Simd::Level::SSE41 : Simd::Level::Scalar);
+#else
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx2")) {
+			return Simd::Level::AVX2;
+		}
+
+		return __builtin_cpu_supports("sse4.1") ? Simd::Level::SSE41 : Simd::Level::Scalar;
+#endif
+	}
+}
+
+namespace Simd {
+	Level getLevel() {
+		static const Level level = detectLevel();
+		return level;
+	}
+
+	const char* getLevelName(const Level level) {
+		switch (level) {
+			case Level::SSE41: return "SSE4.1";
+			case Level::AVX2: return "AVX2";
+			default: return "Scalar";
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+// GCC and Clang need the instruction set enabled per function, MSVC allows intrinsics anywhere
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#endif
+
+namespace Simd {
+	// Ordered, a CPU supporting a level supports every one below it
+	enum class Level : uint8_t {
+		Scalar,
+		SSE41,
+		AVX2,
+		COUNT
+	};
+
+	// Best level this CPU and OS support, detected once
+	Level getLevel();
+
+	const char* getLevelName(const Level level);
+}
\ No newline at end of file
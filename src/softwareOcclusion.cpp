@@ -0,0 +1,326 @@
+#include "softwareOcclusion.h"
+#include <tracy/Tracy.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	struct ScreenPoint {
+		float x, y, z;
+	};
+
+	// Edge functions a * x + b * y + c of the pixel at (x, y), all non-negative when the pixel is fully inside
+	struct Triangle {
+		std::array<float, 3> a, b, c;
+		int minX, maxX, minY, maxY;
+		float depth;
+	};
+
+	// Corners of each box face along its outline, corner bits are x (1), y (2) and z (4) at max
+	constexpr int BOX_FACES[6][4] = {
+		{ 0, 2, 6, 4 },
+		{ 1, 3, 7, 5 },
+		{ 0, 1, 5, 4 },
+		{ 2, 3, 7, 6 },
+		{ 0, 1, 3, 2 },
+		{ 4, 5, 7, 6 },
+	};
+
+	bool projectBox(const glm::mat4& viewProjection, const glm::vec3& min, const glm::vec3& max, const float nearW, std::array<ScreenPoint, 8>& points) {
+		for (int i = 0; i < 8; i++) {
+			const glm::vec3 corner = { (i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z };
+			const glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+
+			if (clip.w <= nearW) {
+				return false;
+			}
+
+			const float inverseW = 1.0f / clip.w;
+			points[i] = {
+				(clip.x * inverseW * 0.5f + 0.5f) * SoftwareOcclusion::WIDTH,
+				(clip.y * inverseW * 0.5f + 0.5f) * SoftwareOcclusion::HEIGHT,
+				clip.z * inverseW * 0.5f + 0.5f
+			};
+		}
+
+		return true;
+	}
+
+	bool setupTriangle(ScreenPoint v0, ScreenPoint v1, ScreenPoint v2, Triangle& triangle) {
+		// Counter clockwise, either winding is accepted since sides are picked by the camera position
+		const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (std::abs(area) < 1e-6f) {
+			return false;
+		}
+
+		if (area < 0.0f) {
+			std::swap(v1, v2);
+		}
+
+		const ScreenPoint vertices[3] = { v0, v1, v2 };
+		for (int edge = 0; edge < 3; edge++) {
+			const ScreenPoint& from = vertices[edge];
+			const ScreenPoint& to = vertices[(edge + 1) % 3];
+
+			const float a = from.y - to.y;
+			const float b = to.x - from.x;
+
+			// Sampled at pixel centers, pulled in by half a pixel so only fully covered pixels pass
+			triangle.a[edge] = a;
+			triangle.b[edge] = b;
+			triangle.c[edge] = -(a * from.x + b * from.y) + 0.5f * (a + b) - 0.5f * (std::abs(a) + std::abs(b));
+		}
+
+		triangle.minX = std::max(0, static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))));
+		triangle.maxX = std::min(SoftwareOcclusion::WIDTH - 1, static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))));
+		triangle.minY = std::max(0, static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+		triangle.maxY = std::min(SoftwareOcclusion::HEIGHT - 1, static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))));
+		triangle.depth = std::max({ v0.z, v1.z, v2.z });
+
+		return triangle.minX <= triangle.maxX && triangle.minY <= triangle.maxY;
+	}
+
+	void rasteriseScalar(const Triangle& triangle, float* depth) {
+		for (int y = triangle.minY; y <= triangle.maxY; y++) {
+			float* row = depth + y * SoftwareOcclusion::WIDTH;
+
+			for (int x = triangle.minX; x <= triangle.maxX; x++) {
+				const float e0 = triangle.a[0] * x + triangle.b[0] * y + triangle.c[0];
+				const float e1 = triangle.a[1] * x + triangle.b[1] * y + triangle.c[1];
+				const float e2 = triangle.a[2] * x + triangle.b[2] * y + triangle.c[2];
+
+				if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+					row[x] = std::min(row[x], triangle.depth);
+				}
+			}
+		}
+	}
+
+	bool anyVisibleScalar(const float* depth, const int minX, const int maxX, const int minY, const int maxY, const float nearestDepth) {
+		for (int y = minY; y <= maxY; y++) {
+			const float* row = depth + y * SoftwareOcclusion::WIDTH;
+
+			for (int x = minX; x <= maxX; x++) {
+				if (row[x] >= nearestDepth) {
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+#if SIMD_X86
+	// Four pixels per step from an aligned start, the edge functions mask off the ones outside
+	SIMD_TARGET_SSE41 void rasteriseSSE41(const Triangle& triangle, float* depth) {
+		const __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		const __m128 triangleDepth = _mm_set1_ps(triangle.depth);
+		const __m128 zero = _mm_setzero_ps();
+		const int startX = triangle.minX & ~3;
+
+		__m128 a[3], step[3];
+		for (int edge = 0; edge < 3; edge++) {
+			a[edge] = _mm_set1_ps(triangle.a[edge]);
+			step[edge] = _mm_set1_ps(triangle.a[edge] * 4.0f);
+		}
+
+		for (int y = triangle.minY; y <= triangle.maxY; y++) {
+			float* row = depth + y * SoftwareOcclusion::WIDTH;
+
+			__m128 e[3];
+			for (int edge = 0; edge < 3; edge++) {
+				const __m128 rowStart = _mm_set1_ps(triangle.a[edge] * startX + triangle.b[edge] * y + triangle.c[edge]);
+				e[edge] = _mm_add_ps(rowStart, _mm_mul_ps(a[edge], offsets));
+			}
+
+			for (int x = startX; x <= triangle.maxX; x += 4) {
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero)), _mm_cmpge_ps(e[2], zero));
+				const __m128 current = _mm_load_ps(row + x);
+				_mm_store_ps(row + x, _mm_blendv_ps(current, _mm_min_ps(current, triangleDepth), inside));
+
+				for (int edge = 0; edge < 3; edge++) {
+					e[edge] = _mm_add_ps(e[edge], step[edge]);
+				}
+			}
+		}
+	}
+
+	SIMD_TARGET_AVX2 void rasteriseAVX2(const Triangle& triangle, float* depth) {
+		const __m256 offsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+		const __m256 triangleDepth = _mm256_set1_ps(triangle.depth);
+		const __m256 zero = _mm256_setzero_ps();
+		const int startX = triangle.minX & ~7;
+
+		__m256 a[3], step[3];
+		for (int edge = 0; edge < 3; edge++) {
+			a[edge] = _mm256_set1_ps(triangle.a[edge]);
+			step[edge] = _mm256_set1_ps(triangle.a[edge] * 8.0f);
+		}
+
+		for (int y = triangle.minY; y <= triangle.maxY; y++) {
+			float* row = depth + y * SoftwareOcclusion::WIDTH;
+
+			__m256 e[3];
+			for (int edge = 0; edge < 3; edge++) {
+				const __m256 rowStart = _mm256_set1_ps(triangle.a[edge] * startX + triangle.b[edge] * y + triangle.c[edge]);
+				e[edge] = _mm256_add_ps(rowStart, _mm256_mul_ps(a[edge], offsets));
+			}
+
+			for (int x = startX; x <= triangle.maxX; x += 8) {
+				const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e[0], zero, _CMP_GE_OQ), _mm256_cmp_ps(e[1], zero, _CMP_GE_OQ)), _mm256_cmp_ps(e[2], zero, _CMP_GE_OQ));
+				const __m256 current = _mm256_load_ps(row + x);
+				_mm256_store_ps(row + x, _mm256_blendv_ps(current, _mm256_min_ps(current, triangleDepth), inside));
+
+				for (int edge = 0; edge < 3; edge++) {
+					e[edge] = _mm256_add_ps(e[edge], step[edge]);
+				}
+			}
+		}
+	}
+
+	// Extra pixels from the aligned start and end only widen the rect, which keeps the test conservative
+	SIMD_TARGET_SSE41 bool anyVisibleSSE41(const float* depth, const int minX, const int maxX, const int minY, const int maxY, const float nearestDepth) {
+		const __m128 boxDepth = _mm_set1_ps(nearestDepth);
+		const __m128i offsets = _mm_setr_epi32(0, 1, 2, 3);
+		const __m128i first = _mm_set1_epi32(minX - 1);
+		const __m128i last = _mm_set1_epi32(maxX + 1);
+
+		for (int y = minY; y <= maxY; y++) {
+			const float* row = depth + y * SoftwareOcclusion::WIDTH;
+
+			for (int x = minX & ~3; x <= maxX; x += 4) {
+				// Lanes outside the rect from the aligned start don't count
+				const __m128i lanes = _mm_add_epi32(_mm_set1_epi32(x), offsets);
+				const __m128i inRect = _mm_and_si128(_mm_cmpgt_epi32(lanes, first), _mm_cmplt_epi32(lanes, last));
+				const __m128 visible = _mm_and_ps(_mm_cmpge_ps(_mm_load_ps(row + x), boxDepth), _mm_castsi128_ps(inRect));
+
+				if (_mm_movemask_ps(visible) != 0) {
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	SIMD_TARGET_AVX2 bool anyVisibleAVX2(const float* depth, const int minX, const int maxX, const int minY, const int maxY, const float nearestDepth) {
+		const __m256 boxDepth = _mm256_set1_ps(nearestDepth);
+		const __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i first = _mm256_set1_epi32(minX - 1);
+		const __m256i last = _mm256_set1_epi32(maxX + 1);
+
+		for (int y = minY; y <= maxY; y++) {
+			const float* row = depth + y * SoftwareOcclusion::WIDTH;
+
+			for (int x = minX & ~7; x <= maxX; x += 8) {
+				const __m256i lanes = _mm256_add_epi32(_mm256_set1_epi32(x), offsets);
+				const __m256i inRect = _mm256_and_si256(_mm256_cmpgt_epi32(lanes, first), _mm256_cmpgt_epi32(last, lanes));
+				const __m256 visible = _mm256_and_ps(_mm256_cmp_ps(_mm256_load_ps(row + x), boxDepth, _CMP_GE_OQ), _mm256_castsi256_ps(inRect));
+
+				if (_mm256_movemask_ps(visible) != 0) {
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+#endif
+
+	void rasterise(const Triangle& triangle, float* depth, const Simd::Level level) {
+#if SIMD_X86
+		if (level >= Simd::Level::AVX2) {
+			rasteriseAVX2(triangle, depth);
+			return;
+		}
+
+		if (level >= Simd::Level::SSE41) {
+			rasteriseSSE41(triangle, depth);
+			return;
+		}
+#endif
+
+		rasteriseScalar(triangle, depth);
+	}
+}
+
+void SoftwareOcclusion::render(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, std::span<const OccluderBox> occluders, const Simd::Level level) {
+	ZoneScopedN("Software Occlusion Render");
+
+	this->viewProjection = viewProjection;
+	depth.fill(1.0f);
+
+	std::array<ScreenPoint, 8> points;
+	Triangle triangle;
+
+	for (const OccluderBox& occluder : occluders) {
+		// Occluders crossing the near plane are dropped, which only makes culling less aggressive
+		if (!projectBox(viewProjection, occluder.min, occluder.max, NEAR_W, points)) {
+			continue;
+		}
+
+		// Only the sides facing the camera (-x, +x, -y, +y, -z, +z)
+		const bool facing[6] = {
+			cameraPosition.x < occluder.min.x, cameraPosition.x > occluder.max.x,
+			cameraPosition.y < occluder.min.y, cameraPosition.y > occluder.max.y,
+			cameraPosition.z < occluder.min.z, cameraPosition.z > occluder.max.z,
+		};
+
+		for (int face = 0; face < 6; face++) {
+			if (!facing[face]) {
+				continue;
+			}
+
+			const int* corners = BOX_FACES[face];
+
+			if (setupTriangle(points[corners[0]], points[corners[1]], points[corners[2]], triangle)) {
+				rasterise(triangle, depth.data(), level);
+			}
+
+			if (setupTriangle(points[corners[0]], points[corners[2]], points[corners[3]], triangle)) {
+				rasterise(triangle, depth.data(), level);
+			}
+		}
+	}
+}
+
+bool SoftwareOcclusion::isVisible(const glm::vec3& min, const glm::vec3& max, const Simd::Level level) const {
+	std::array<ScreenPoint, 8> points;
+	if (!projectBox(viewProjection, min, max, NEAR_W, points)) {
+		return true;
+	}
+
+	float minScreenX = points[0].x, maxScreenX = points[0].x;
+	float minScreenY = points[0].y, maxScreenY = points[0].y;
+	float nearestDepth = points[0].z;
+
+	for (const ScreenPoint& point : points) {
+		minScreenX = std::min(minScreenX, point.x);
+		maxScreenX = std::max(maxScreenX, point.x);
+		minScreenY = std::min(minScreenY, point.y);
+		maxScreenY = std::max(maxScreenY, point.y);
+		nearestDepth = std::min(nearestDepth, point.z);
+	}
+
+	// Every pixel the rect touches
+	const int minX = std::max(0, static_cast<int>(std::floor(minScreenX)));
+	const int maxX = std::min(WIDTH - 1, static_cast<int>(std::floor(maxScreenX)));
+	const int minY = std::max(0, static_cast<int>(std::floor(minScreenY)));
+	const int maxY = std::min(HEIGHT - 1, static_cast<int>(std::floor(maxScreenY)));
+
+	// Off screen, left to frustum culling
+	if (minX > maxX || minY > maxY) {
+		return true;
+	}
+
+#if SIMD_X86
+	if (level >= Simd::Level::AVX2) {
+		return anyVisibleAVX2(depth.data(), minX, maxX, minY, maxY, nearestDepth);
+	}
+
+	if (level >= Simd::Level::SSE41) {
+		return anyVisibleSSE41(depth.data(), minX, maxX, minY, maxY, nearestDepth);
+	}
+#endif
+
+	return anyVisibleScalar(depth.data(), minX, maxX, minY, maxY, nearestDepth);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "simd.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <span>
+
+// Solid box hiding whatever lies behind it
+struct OccluderBox {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// Low resolution CPU depth buffer for machines without GPU culling. Occluders only cover pixels they fully contain
+// and write their farthest depth, so a box it rejects is hidden for certain
+class SoftwareOcclusion {
+public:
+	static constexpr int WIDTH = 256;
+	static constexpr int HEIGHT = 144;
+
+	// Clears and rasterises the camera facing sides of every occluder
+	void render(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, std::span<const OccluderBox> occluders, const Simd::Level level = Simd::getLevel());
+
+	// Tests against the last render, boxes crossing the near plane are always visible
+	bool isVisible(const glm::vec3& min, const glm::vec3& max, const Simd::Level level = Simd::getLevel()) const;
+
+	const float* getDepth() const { return depth.data(); }
+
+private:
+	alignas(32) std::array<float, WIDTH * HEIGHT> depth;
+	glm::mat4 viewProjection = glm::mat4(1.0f);
+
+	// Points closer than this (clip w) can't be bounded on screen
+	static constexpr float NEAR_W = 0.05f;
+};
\ No newline at end of file
@@ -13,6 +13,17 @@ static constexpr int MAX_HEIGHT = 128;
 static constexpr int MAX_VOXELS = CHUNK_SIZE * MAX_HEIGHT * CHUNK_SIZE;
 static constexpr int WATER_HEIGHT = MAX_HEIGHT / 2;
 static constexpr int MAX_MODEL_SIZE = 32;
+static constexpr int MAX_RENDER_DISTANCE = 64;
+
+// Chunks are stored as a vertical stack of cubic sections
+static constexpr int SECTION_HEIGHT = CHUNK_SIZE;
+static constexpr int SECTION_COUNT = MAX_HEIGHT / SECTION_HEIGHT;
+static constexpr int SECTION_VOXELS = CHUNK_SIZE * SECTION_HEIGHT * CHUNK_SIZE;
+static_assert(MAX_HEIGHT % SECTION_HEIGHT == 0, "MAX_HEIGHT must be a multiple of SECTION_HEIGHT");
+
+// One bit per section, for dirty tracking
+static constexpr uint32_t ALL_SECTIONS = (SECTION_COUNT >= 32) ? ~0u : ((1u << SECTION_COUNT) - 1);
+static_assert(SECTION_COUNT <= 32, "Section bitmasks are 32 bits");
 
 struct Material {
 	glm::vec3 ambient = glm::vec3(1.0f);
@@ -103,20 +114,22 @@ struct VertexOld {
 	glm::vec3 normal;
 };
 
-// Position: 6 bits per axis (64 possible values)
-// Position y: 8 bits per axis (256 possible values)
+// Position: 5 bits per axis (32 possible values)
+// Position y: 7 bits (128 possible values)
 // Face: 3 bits total (8 possible values, 6 faces)
-// TexID: x bits (remaining bits, 9 for now)
+// TexID: 4 bits (16 possible values)
+// Size: width - 1 and height - 1, 4 bits each (merged quads up to 16 x 16)
 struct Face {
 	uint32_t packed = 0;
 };
 
 namespace FacePacked {
 	// Bit widths
-	constexpr uint8_t POSITION_BITS = 6;
-	constexpr uint8_t POSITION_Y_BITS = 8;
+	constexpr uint8_t POSITION_BITS = 5;
+	constexpr uint8_t POSITION_Y_BITS = 7;
 	constexpr uint8_t FACE_BITS = 3;
-	constexpr uint8_t TEXID_BITS = 9;
+	constexpr uint8_t TEXID_BITS = 4;
+	constexpr uint8_t SIZE_BITS = 4;
 
 	// Bit shifts
 	constexpr uint8_t X_SHIFT = 0;
@@ -124,12 +137,21 @@ namespace FacePacked {
 	constexpr uint8_t Z_SHIFT = Y_SHIFT + POSITION_Y_BITS;
 	constexpr uint8_t FACE_SHIFT = Z_SHIFT + POSITION_BITS;
 	constexpr uint8_t TEXID_SHIFT = FACE_SHIFT + FACE_BITS;
+	constexpr uint8_t WIDTH_SHIFT = TEXID_SHIFT + TEXID_BITS;
+	constexpr uint8_t HEIGHT_SHIFT = WIDTH_SHIFT + SIZE_BITS;
 
 	// Bit masks
 	constexpr uint32_t POSITION_MASK = (1 << POSITION_BITS) - 1;
 	constexpr uint32_t POSITION_Y_MASK = (1 << POSITION_Y_BITS) - 1;
 	constexpr uint32_t FACE_MASK = (1 << FACE_BITS) - 1;
 	constexpr uint32_t TEXID_MASK = (1 << TEXID_BITS) - 1;
+	constexpr uint32_t SIZE_MASK = (1 << SIZE_BITS) - 1;
+
+	// Largest merged quad side, greedy meshing stops growing a quad here
+	constexpr int MAX_SIZE = 1 << SIZE_BITS;
+
+	static_assert(HEIGHT_SHIFT + SIZE_BITS <= 32, "Packed face doesn't fit in 32 bits");
+	static_assert(CHUNK_SIZE <= (1 << POSITION_BITS) && MAX_HEIGHT <= (1 << POSITION_Y_BITS), "Chunk dimensions don't fit in a packed face");
 
 	inline void setPosition(Face& face, const glm::ivec3& position) {
 		face.packed &= ~((POSITION_MASK << X_SHIFT) | (POSITION_Y_MASK << Y_SHIFT) | (POSITION_MASK << Z_SHIFT));
@@ -159,6 +181,17 @@ namespace FacePacked {
 	inline uint16_t getTexID(const Face& face) {
 		return static_cast<uint16_t>((face.packed >> TEXID_SHIFT) & TEXID_MASK);
 	}
+
+	// Width runs along the face's local x axis and height along its local y (see faceRotations in the shaders)
+	inline void setSize(Face& face, const int width, const int height) {
+		face.packed &= ~((SIZE_MASK << WIDTH_SHIFT) | (SIZE_MASK << HEIGHT_SHIFT));
+		face.packed |= ((static_cast<uint32_t>(width - 1) & SIZE_MASK) << WIDTH_SHIFT);
+		face.packed |= ((static_cast<uint32_t>(height - 1) & SIZE_MASK) << HEIGHT_SHIFT);
+	}
+
+	inline glm::ivec2 getSize(const Face& face) {
+		return glm::ivec2(static_cast<int>((face.packed >> WIDTH_SHIFT) & SIZE_MASK) + 1, static_cast<int>((face.packed >> HEIGHT_SHIFT) & SIZE_MASK) + 1);
+	}
 }
 
 struct Texel {
@@ -186,6 +219,9 @@ enum class VoxelType : uint8_t {
 	COUNT
 };
 
+// Voxel types double as texture IDs in packed faces
+static_assert(static_cast<uint32_t>(VoxelType::COUNT) <= (1u << FacePacked::TEXID_BITS), "Voxel types don't fit in a packed face");
+
 struct VoxelData {
 	const char* name;
 	Texel color;
@@ -209,6 +245,12 @@ struct Voxel {
 	VoxelType type = VoxelType::EMPTY;
 };
 
+// A voxel to set, in world or chunk space depending on the API
+struct VoxelEdit {
+	glm::ivec3 position;
+	VoxelType type = VoxelType::STONE;
+};
+
 struct Dimensions {
 	uint8_t x = 0;
 	uint8_t y = 0;
@@ -223,7 +265,17 @@ struct VoxelModel {
 struct Masks {
 	std::array<uint32_t, CHUNK_SIZE* MAX_HEIGHT> opaque;
 	std::array<uint32_t, CHUNK_SIZE* MAX_HEIGHT> liquid;
+};
+
+// Copy of a chunk's voxels taken once per mesh build, types are in mask row order
+struct ChunkSnapshot {
+	Masks masks;
 	std::array<uint32_t, CHUNK_SIZE* MAX_HEIGHT> filled;
+	std::array<VoxelType, MAX_VOXELS> types;
+
+	VoxelType getType(const int x, const int y, const int z) const {
+		return types[(y * CHUNK_SIZE + z) * CHUNK_SIZE + x];
+	}
 };
 
 struct VoxelVolume {
@@ -10,79 +10,42 @@
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <chrono>
-#include <thread>
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
 #include <tracy/Tracy.hpp>
 
-World::World(GenerationType generationType, uint32_t seed) : generationType(generationType), seed(seed) {
-
+World::World(FacePool& facePool, GenerationType generationType, uint32_t seed, int maxRenderDistance, unsigned int workerCount) : facePool(facePool), chunkPool(CHUNK_POOL_SIZE), grid(getGridRadius(maxRenderDistance)), generationType(generationType), seed(seed) {
+	jobSystem = std::make_unique<JobSystem>(workerCount);
 }
 
 World::~World() {
-	// Handle generation threads
-	stopGeneration.store(true);
-	generationCondition.notify_all();
-
-	for (auto& thread : generationThreads) {
-		if (thread.joinable()) {
-			thread.join();
-		}
-	}
-
-	// Handle meshing threads
-	stopMeshing.store(true);
-	meshingCondition.notify_all();
-
-	for (auto& thread : meshingThreads) {
-		if (thread.joinable()) {
-			thread.join();
-		}
-	}
+	// Stop workers before anything they reference is destroyed
+	jobSystem.reset();
 }
 
 void World::update(const glm::ivec3& worldPosition, const int renderDistance, const glm::mat4& view, const glm::mat4& projection) {
 	// Extract frustrum planes (for culling)
-	const glm::mat4 vpt = glm::transpose(projection * view);
-	const std::vector<glm::vec4> frustumPlanes = {
-		(vpt[3] + vpt[0]),
-		(vpt[3] - vpt[0]),
-		(vpt[3] + vpt[1]),
-		(vpt[3] - vpt[1]),
-		(vpt[3] + vpt[2]),
-		(vpt[3] - vpt[2])
-	};
+	const Frustum frustum = Frustum::fromViewProjection(projection * view);
 
 	glm::ivec2 centerChunkIndex = getChunkIndex(worldPosition);
-	chunksToDraw.clear();
-
-	{
-		ZoneScopedN("Unload Chunks");
-		std::shared_lock lock1(chunksMutex);
 
-		const int unloadDistance = static_cast<int>(renderDistance * 1.5f);
-
-		for (auto it = chunks.begin(); it != chunks.end();) {
-			const glm::ivec2& chunkIndex = it->first;
+	// Occluders are rasterised on a worker while chunks are processed, from last frame's draw list
+	const bool softwareOcclusionActive = softwareOcclusionEnabled && !gpuCullingEnabled;
+	if (softwareOcclusionActive) {
+		submitOcclusion(glm::vec3(worldPosition), projection * view);
+	}
 
-			if (std::abs(chunkIndex.x - centerChunkIndex.x) > unloadDistance || std::abs(chunkIndex.y - centerChunkIndex.y) > unloadDistance) {
-				it = chunks.erase(it);
-			}
-			else {
-				it++;
-			}
-		}
-		std::shared_lock lock2(meshesMutex);
+	chunksToDraw.clear();
+	sectionBounds.clear();
+	sectionBoundsEnd.clear();
+	frameIndex++;
 
-		for (auto it = meshes.begin(); it != meshes.end();) {
-			const glm::ivec2& chunkIndex = it->first;
+	// Evict and free GL objects within a fixed slice of the frame
+	evictChunks(centerChunkIndex, renderDistance);
+	facePool.flushDeferred(MESH_DELETION_TIME_BUDGET);
 
-			if (std::abs(chunkIndex.x - centerChunkIndex.x) > unloadDistance || std::abs(chunkIndex.y - centerChunkIndex.y) > unloadDistance) {
-				it = meshes.erase(it);
-			}
-			else {
-				it++;
-			}
-		}
-	}
+	updateEditBatches();
 
 	{
 		ZoneScopedN("Process Chunks");
@@ -97,23 +60,22 @@ void World::update(const glm::ivec3& worldPosition, const int renderDistance, co
 				glm::ivec2 currentChunkPos = centerChunkIndex + glm::ivec2(x, z);
 				std::shared_ptr<ChunkMesh> currentMesh;
 
-				// Skip if chunk isn't visible
-				if (!frustrumAABBVisibility(currentChunkPos, frustumPlanes)) {
+				ChunkSlot* slot = grid.find(currentChunkPos);
+				if (!slot) {
 					continue;
 				}
 
-				// Skip if mesh doesn't exist
-				{
-					std::shared_lock lock(meshesMutex);
-
-					auto it = meshes.find(currentChunkPos);
-					if (it == meshes.end()) {
-						continue;
-					}
+				// In the window counts as used for eviction, meshed or not
+				slot->lastUsedFrame.store(frameIndex);
 
-					currentMesh = it->second;
+				// Skip if chunk hasn't been meshed yet
+				const ChunkState state = slot->state.load();
+				if (state < ChunkState::Meshing || state > ChunkState::Uploaded) {
+					continue;
 				}
 
+				currentMesh = slot->mesh.load();
+
 				// Calculate max distance and distance to chunk center in world space
 				glm::vec2 chunkCenterWorld = getChunkCenterWorld(currentChunkPos);
 				float distanceToChunkCenterWorld = glm::length(chunkCenterWorld - glm::vec2(worldPosition.x, worldPosition.z));
@@ -124,39 +86,148 @@ void World::update(const glm::ivec3& worldPosition, const int renderDistance, co
 					continue;
 				}
 
-				// Update mesh
-				currentMesh->update();
+				// Update mesh, unless it's waiting on the rest of its edit batch (keeps drawing the old one)
+				const bool held = !heldChunkKeys.empty() && heldChunkKeys.contains(ChunkGrid::packKey(currentChunkPos));
+				if (held && currentMesh->hasPendingUpload()) {
+					editBatchStats.heldUploads++;
+				}
+
+				// Off-screen builds wait until they come into view, the new faces' bounds aren't known before upload so the whole column is tested
+				if (!held && currentMesh->hasPendingUpload()) {
+					const glm::vec3 columnMin = glm::vec3(currentChunkPos.x * CHUNK_SIZE, 0.0f, currentChunkPos.y * CHUNK_SIZE);
+
+					if (frustum.intersects(columnMin, columnMin + glm::vec3(CHUNK_SIZE, MAX_HEIGHT, CHUNK_SIZE))) {
+						currentMesh->update(facePool);
+					}
+				}
+
+				if (!held && currentMesh->isValid() && !currentMesh->hasPendingUpload()) {
+					const uint32_t generation = slot->generation.load();
+					grid.transition(*slot, generation, ChunkState::Meshed, ChunkState::Uploaded);
+
+					const size_t meshBytes = currentMesh->getMemoryUsage();
+					if (meshBytes != slot->meshBytes.load()) {
+						grid.setMeshBytes(*slot, generation, meshBytes);
+					}
+				}
 
 				// Skip if mesh isn't valid
 				if (!currentMesh->isValid()) {
 					continue;
 				}
 
+				// Skip if the Y range holding faces isn't visible (empty and buried sections don't count)
+				if (currentMesh->getMinY() > currentMesh->getMaxY()) {
+					continue;
+				}
+
+				// Frustum culled in one batch after the loop, a box for each section holding faces
+				if (!gpuCullingEnabled) {
+					const glm::vec3 chunkOrigin = glm::vec3(currentChunkPos.x * CHUNK_SIZE, 0.0f, currentChunkPos.y * CHUNK_SIZE);
+
+					for (int section = 0; section < SECTION_COUNT; section++) {
+						const int sectionMinY = currentMesh->getSectionMinY(section);
+						const int sectionMaxY = currentMesh->getSectionMaxY(section);
+
+						if (sectionMinY <= sectionMaxY) {
+							sectionBounds.push(chunkOrigin + glm::vec3(0.0f, sectionMinY, 0.0f), chunkOrigin + glm::vec3(CHUNK_SIZE, sectionMaxY + 1, CHUNK_SIZE));
+						}
+					}
+
+					sectionBoundsEnd.push_back(static_cast<uint32_t>(sectionBounds.size()));
+				}
+
 				// Add to draw list
 				chunksToDraw.push_back({ currentMesh, currentChunkPos * CHUNK_SIZE, distanceToChunkCenterWorld });
 			}
 		}
 	}
 
+	if (!gpuCullingEnabled) {
+		cullFrustum(frustum);
+	}
+
+	updateEditLatency(frustum);
+
+	softwareOccludedCount = 0;
+	if (softwareOcclusionActive) {
+		cullOccluded();
+	}
+
 	renderedChunkCount = chunksToDraw.size();
+
+	renderedFaceCount = 0;
+	renderedUnmergedFaceCount = 0;
+	for (const ChunkDrawingInfo& chunkInfo : chunksToDraw) {
+		renderedFaceCount += chunkInfo.mesh->getFaceCount();
+		renderedUnmergedFaceCount += chunkInfo.mesh->getUnmergedFaceCount();
+	}
 }
 
-void World::drawOpaque(const glm::ivec3& worldPosition, const int renderDistance, const glm::mat4& view, const glm::mat4& projection, Shader& shader, const bool wireframe) {
+// Camera matrices come from the renderer's camera uniform buffer
+void World::drawOpaque(const glm::ivec3& worldPosition, const int renderDistance, const bool wireframe) {
 	ZoneScopedN("World Draw");
 
+	drawChunks(false, wireframe);
+}
+
+void World::drawWater(const glm::ivec3& worldPosition, const int renderDistance, const bool wireframe) {
+	ZoneScopedN("World Draw Water");
+
+	drawChunks(true, wireframe);
+}
+
+void World::cullChunks(const Shader& cullShader) {
+	ZoneScopedN("World Cull");
+
+	cullInputs.clear();
+
+	for (const ChunkDrawingInfo& chunkInfo : chunksToDraw) {
+		const Mesh* opaque = chunkInfo.mesh->getOpaqueMesh();
+		const Mesh* liquid = chunkInfo.mesh->getLiquidMesh();
+
+		cullInputs.push_back({
+			glm::vec4(chunkInfo.offset.x, chunkInfo.mesh->getMinY(), chunkInfo.offset.y, 1.0f),
+			glm::vec4(chunkInfo.offset.x + CHUNK_SIZE, chunkInfo.mesh->getMaxY() + 1, chunkInfo.offset.y + CHUNK_SIZE, 1.0f),
+			opaque ? opaque->getDrawCommand() : DrawArraysIndirectCommand{},
+			liquid ? liquid->getDrawCommand() : DrawArraysIndirectCommand{}
+		});
+	}
+
+	facePool.cull(cullInputs, cullShader, occlusionCullingEnabled);
+}
+
+// Every visible chunk in one multi-draw, in chunksToDraw order (or in cull order with GPU culling)
+void World::drawChunks(const bool liquid, const bool wireframe) {
+	// Gather draw commands (the cull pass already wrote them with GPU culling)
+	if (!gpuCullingEnabled) {
+		ZoneScopedN("Gather Draw Commands");
+
+		drawCommands.clear();
+		drawOffsets.clear();
+
+		for (const ChunkDrawingInfo& chunkInfo : chunksToDraw) {
+			const Mesh* mesh = liquid ? chunkInfo.mesh->getLiquidMesh() : chunkInfo.mesh->getOpaqueMesh();
+			if (!mesh || mesh->getFaceCount() == 0) {
+				continue;
+			}
+
+			drawCommands.push_back(mesh->getDrawCommand());
+			drawOffsets.emplace_back(chunkInfo.offset.x, 0.0f, chunkInfo.offset.y, 0.0f);
+		}
+	}
+
 	// Set polygon mode to line if wireframe mode enabled
 	if (wireframe) {
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 		glDisable(GL_CULL_FACE);
 	}
 
-	// Draw chunks
-	{
-		ZoneScopedN("Draw Chunks");
-
-		for (const ChunkDrawingInfo& chunkInfo : chunksToDraw) {
-			chunkInfo.mesh->drawOpaque(chunkInfo.offset, view, projection, shader);
-		}
+	if (gpuCullingEnabled) {
+		facePool.drawCulled(liquid ? FacePass::Liquid : FacePass::Opaque);
+	}
+	else {
+		facePool.draw(drawCommands, drawOffsets);
 	}
 
 	// Reset polygon mode if wireframe mode enabled
@@ -166,85 +237,348 @@ void World::drawOpaque(const glm::ivec3& worldPosition, const int renderDistance
 	}
 }
 
-void World::drawWater(const glm::ivec3& worldPosition, const int renderDistance, const glm::mat4& view, const glm::mat4& projection, Shader& shader, const bool wireframe) {
-	ZoneScopedN("World Draw Water");
+// Keeps chunks with at least one section box in the frustum, in their original order
+void World::cullFrustum(const Frustum& frustum) {
+	ZoneScopedN("Cull Frustum");
 
-	// Set polygon mode to line if wireframe mode enabled
-	if (wireframe) {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		glDisable(GL_CULL_FACE);
+	sectionBounds.cull(frustum, sectionVisible);
+
+	size_t keptCount = 0;
+	size_t firstSection = 0;
+
+	for (size_t i = 0; i < chunksToDraw.size(); i++) {
+		const size_t endSection = sectionBoundsEnd[i];
+		const bool visible = std::find(sectionVisible.begin() + firstSection, sectionVisible.begin() + endSection, uint8_t(1)) != sectionVisible.begin() + endSection;
+		firstSection = endSection;
+
+		if (visible) {
+			chunksToDraw[keptCount++] = std::move(chunksToDraw[i]);
+		}
 	}
 
-	// Draw chunks
-	{
-		ZoneScopedN("Draw Chunks");
+	chunksToDraw.resize(keptCount);
+}
 
-		for (const ChunkDrawingInfo& chunkInfo : chunksToDraw) {
-			chunkInfo.mesh->drawWater(chunkInfo.offset, view, projection, shader);
+void World::submitOcclusion(const glm::vec3& cameraPosition, const glm::mat4& viewProjection) {
+	ZoneScopedN("Submit Occlusion");
+
+	occluders.clear();
+
+	// Closest chunks hide the most
+	const size_t occluderChunkCount = std::min(chunksToDraw.size(), MAX_OCCLUDER_CHUNKS);
+	std::partial_sort(chunksToDraw.begin(), chunksToDraw.begin() + occluderChunkCount, chunksToDraw.end(), [](const ChunkDrawingInfo& a, const ChunkDrawingInfo& b) {
+		return a.distance < b.distance;
+	});
+
+	for (size_t i = 0; i < occluderChunkCount; i++) {
+		const ChunkDrawingInfo& chunkInfo = chunksToDraw[i];
+		const ChunkMesh::OccluderHeights& heights = chunkInfo.mesh->getOccluderHeights();
+
+		for (int tileZ = 0; tileZ < ChunkMesh::OCCLUDER_TILES; tileZ++) {
+			for (int tileX = 0; tileX < ChunkMesh::OCCLUDER_TILES; tileX++) {
+				const int height = heights[tileZ * ChunkMesh::OCCLUDER_TILES + tileX];
+				if (height == 0) {
+					continue;
+				}
+
+				const glm::vec3 min = glm::vec3(chunkInfo.offset.x + tileX * ChunkMesh::OCCLUDER_TILE_SIZE, 0.0f, chunkInfo.offset.y + tileZ * ChunkMesh::OCCLUDER_TILE_SIZE);
+				occluders.push_back({ min, min + glm::vec3(ChunkMesh::OCCLUDER_TILE_SIZE, height, ChunkMesh::OCCLUDER_TILE_SIZE) });
+			}
 		}
 	}
 
-	// Reset polygon mode if wireframe mode enabled
-	if (wireframe) {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glEnable(GL_CULL_FACE);
+	occlusionViewProjection = viewProjection;
+	occlusionCameraPosition = cameraPosition;
+	occlusionJobState.store(OcclusionJobState::Queued);
+
+	jobSystem->submit(JobType::Occlusion, std::numeric_limits<float>::max(), [this]() {
+		renderOccluders();
+	});
+}
+
+// Whoever claims the queued render does it, a job left over from an earlier frame finds nothing to claim
+void World::renderOccluders() {
+	OcclusionJobState expected = OcclusionJobState::Queued;
+	if (!occlusionJobState.compare_exchange_strong(expected, OcclusionJobState::Running)) {
+		return;
 	}
+
+	softwareOcclusion.render(occlusionViewProjection, occlusionCameraPosition, occluders);
+
+	occlusionJobState.store(OcclusionJobState::Done);
+	occlusionJobState.notify_all();
+}
+
+void World::cullOccluded() {
+	ZoneScopedN("Cull Occluded");
+
+	// Render here if no worker got to it, otherwise wait for the one that did
+	renderOccluders();
+	occlusionJobState.wait(OcclusionJobState::Running);
+	occlusionJobState.store(OcclusionJobState::Idle);
+
+	const size_t candidateCount = chunksToDraw.size();
+
+	std::erase_if(chunksToDraw, [this](const ChunkDrawingInfo& chunkInfo) {
+		const glm::vec3 min = glm::vec3(chunkInfo.offset.x, chunkInfo.mesh->getMinY(), chunkInfo.offset.y);
+		const glm::vec3 max = glm::vec3(chunkInfo.offset.x + CHUNK_SIZE, chunkInfo.mesh->getMaxY() + 1, chunkInfo.offset.y + CHUNK_SIZE);
+
+		return !softwareOcclusion.isVisible(min, max);
+	});
+
+	softwareOccludedCount = candidateCount - chunksToDraw.size();
 }
 
 bool World::hasVoxel(const glm::ivec3& worldPosition) {
 	glm::ivec2 chunkIndex = getChunkIndex(worldPosition);
 
-	std::shared_ptr<Chunk> chunk;
-	{
-		std::shared_lock lock(chunksMutex);
-		auto it = chunks.find(chunkIndex);
-		if (it == chunks.end()) {
-			return false;
-		}
-		chunk = it->second;
+	std::shared_ptr<Chunk> chunk = grid.getChunk(chunkIndex);
+	if (!chunk) {
+		return false;
 	}
 
 	glm::ivec3 localPosition = getLocalPosition(worldPosition);
 	return chunk->hasVoxel(localPosition);
 }
 
-void World::addVoxel(const glm::ivec3& worldPosition) {
-	glm::ivec2 chunkIndex = getChunkIndex(worldPosition);
+void World::addVoxel(const glm::ivec3& worldPosition, const VoxelType type) {
+	const VoxelEdit edit = { worldPosition, type };
+	applyEdits(std::span<const VoxelEdit>(&edit, 1));
+}
 
-	std::shared_ptr<Chunk> chunk;
-	{
-		std::shared_lock lock(chunksMutex);
-		auto it = chunks.find(chunkIndex);
-		if (it == chunks.end()) {
-			return;
+void World::removeVoxel(const glm::ivec3& worldPosition) {
+	addVoxel(worldPosition, VoxelType::EMPTY);
+}
+
+// Applies edits in world space grouped by chunk (one lock each), then remeshes every touched chunk once
+// Neighbors seeing a changed border voxel remesh too, and all of them upload in the same frame
+void World::applyEdits(const std::span<const VoxelEdit> edits) {
+	ZoneScopedN("Apply Edits");
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// Group into chunk space edits, keeping the order within each chunk
+	std::unordered_map<uint64_t, std::vector<VoxelEdit>> chunkEdits;
+	for (const VoxelEdit& edit : edits) {
+		chunkEdits[ChunkGrid::packKey(getChunkIndex(edit.position))].push_back({ getLocalPosition(edit.position), edit.type });
+	}
+
+	// Sections to remesh per chunk, whether edited directly or seen across a border
+	std::unordered_map<uint64_t, uint32_t> remeshSections;
+
+	for (const auto& [key, localEdits] : chunkEdits) {
+		const glm::ivec2 chunkIndex = ChunkGrid::unpackKey(key);
+
+		std::shared_ptr<Chunk> chunk = grid.getChunk(chunkIndex);
+		if (!chunk) {
+			continue;
+		}
+
+		const ChunkEditResult result = chunk->setVoxelTypes(localEdits);
+		if (result.changed == 0) {
+			continue;
+		}
+
+		remeshSections.try_emplace(key, 0u);
+
+		for (size_t side = 0; side < result.borderSections.size(); side++) {
+			if (result.borderSections[side] != 0) {
+				remeshSections[ChunkGrid::packKey(chunkIndex + DirectionVectors2D::arr[side])] |= result.borderSections[side];
+			}
 		}
-		chunk = it->second;
 	}
 
-	glm::ivec3 localPosition = getLocalPosition(worldPosition);
-	chunk->setVoxelType(localPosition, VoxelType::STONE);
+	EditBatch batch;
+	batch.startFrame = frameIndex;
+
+	for (const auto& [key, sections] : remeshSections) {
+		const glm::ivec2 chunkIndex = ChunkGrid::unpackKey(key);
+
+		// Edited chunks marked their own sections, neighbors only get the border ones
+		if (sections != 0) {
+			std::shared_ptr<Chunk> neighbor = grid.getChunk(chunkIndex);
+			if (!neighbor) {
+				continue;
+			}
+
+			neighbor->markSectionsDirty(sections);
+		}
+
+		if (requestRemesh(chunkIndex)) {
+			batch.chunks.push_back({ chunkIndex, grid.find(chunkIndex)->generation.load() });
+		}
+	}
+
+	if (!batch.chunks.empty()) {
+		editLatencyProbes.push_back({ batch.chunks, startTime });
+	}
+
+	// A single chunk has nothing to wait for
+	if (batch.chunks.size() > 1) {
+		editBatches.push_back(std::move(batch));
+	}
 }
 
-void World::removeVoxel(const glm::ivec3& worldPosition) {
-	glm::ivec2 chunkIndex = getChunkIndex(worldPosition);
+// Every voxel in the inclusive box
+void World::fillBox(const glm::ivec3& min, const glm::ivec3& max, const VoxelType type) {
+	const glm::ivec3 from = glm::min(min, max);
+	const glm::ivec3 to = glm::max(min, max);
 
-	std::shared_ptr<Chunk> chunk;
-	{
-		std::shared_lock lock(chunksMutex);
-		auto it = chunks.find(chunkIndex);
-		if (it == chunks.end()) {
-			return;
+	std::vector<VoxelEdit> edits;
+	edits.reserve(static_cast<size_t>(to.x - from.x + 1) * (to.y - from.y + 1) * (to.z - from.z + 1));
+
+	for (int z = from.z; z <= to.z; z++) {
+		for (int y = from.y; y <= to.y; y++) {
+			for (int x = from.x; x <= to.x; x++) {
+				edits.push_back({ glm::ivec3(x, y, z), type });
+			}
 		}
-		chunk = it->second;
 	}
 
-	glm::ivec3 localPosition = getLocalPosition(worldPosition);
-	chunk->setVoxelType(localPosition, VoxelType::EMPTY);
+	applyEdits(edits);
+}
+
+// Every voxel whose center is within radius of the center voxel's
+void World::fillSphere(const glm::ivec3& center, const int radius, const VoxelType type) {
+	const int radiusSquared = radius * radius;
+
+	std::vector<VoxelEdit> edits;
+
+	for (int z = -radius; z <= radius; z++) {
+		for (int y = -radius; y <= radius; y++) {
+			for (int x = -radius; x <= radius; x++) {
+				if (x * x + y * y + z * z <= radiusSquared) {
+					edits.push_back({ center + glm::ivec3(x, y, z), type });
+				}
+			}
+		}
+	}
+
+	applyEdits(edits);
+}
+
+// Batches whose chunks are all meshed are released to upload this frame, the rest hold their chunks back
+void World::updateEditBatches() {
+	ZoneScopedN("Update Edit Batches");
+
+	heldChunkKeys.clear();
+
+	std::erase_if(editBatches, [this](const EditBatch& batch) {
+		bool ready = true;
+
+		for (const auto& [chunkIndex, generation] : batch.chunks) {
+			ChunkSlot* slot = grid.find(chunkIndex);
+
+			// Evicted or reassigned chunks aren't waited on
+			if (!slot || slot->generation.load() != generation) {
+				continue;
+			}
+
+			std::shared_ptr<Chunk> chunk = slot->chunk.load();
+			if (slot->state.load() == ChunkState::Meshing || (chunk && chunk->isDirty())) {
+				ready = false;
+				break;
+			}
+		}
+
+		if (ready) {
+			editBatchStats.released++;
+			return true;
+		}
+
+		// Don't hold chunks forever under a stream of edits
+		if (frameIndex - batch.startFrame > EDIT_BATCH_MAX_FRAMES) {
+			editBatchStats.timedOut++;
+			return true;
+		}
+
+		for (const auto& entry : batch.chunks) {
+			heldChunkKeys.insert(ChunkGrid::packKey(entry.first));
+		}
+
+		return false;
+	});
+}
+
+// Records the latency of edits whose visible chunks all have their new meshes uploaded (run after this frame's uploads)
+void World::updateEditLatency(const Frustum& frustum) {
+	const auto now = std::chrono::steady_clock::now();
+
+	std::erase_if(editLatencyProbes, [this, &frustum, now](const EditLatencyProbe& probe) {
+		for (const auto& [chunkIndex, generation] : probe.chunks) {
+			ChunkSlot* slot = grid.find(chunkIndex);
+
+			// Evicted or reassigned chunks aren't waited on, neither are off-screen ones (they defer their upload)
+			if (!slot || slot->generation.load() != generation) {
+				continue;
+			}
+
+			const glm::vec3 columnMin = glm::vec3(chunkIndex.x * CHUNK_SIZE, 0.0f, chunkIndex.y * CHUNK_SIZE);
+			if (!frustum.intersects(columnMin, columnMin + glm::vec3(CHUNK_SIZE, MAX_HEIGHT, CHUNK_SIZE))) {
+				continue;
+			}
+
+			std::shared_ptr<Chunk> chunk = slot->chunk.load();
+			std::shared_ptr<ChunkMesh> mesh = slot->mesh.load();
+
+			if (slot->state.load() == ChunkState::Meshing || (chunk && chunk->isDirty()) || (mesh && mesh->hasPendingUpload())) {
+				if (now - probe.startTime > EDIT_LATENCY_TIMEOUT) {
+					editLatencyStats.timedOut++;
+					return true;
+				}
+
+				return false;
+			}
+		}
+
+		const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - probe.startTime);
+
+		editLatencyStats.count++;
+		editLatencyStats.last = latency;
+		editLatencyStats.average += (latency - editLatencyStats.average) / static_cast<long long>(editLatencyStats.count);
+		editLatencyStats.max = std::max(editLatencyStats.max, latency);
+
+		return true;
+	});
+}
+
+ChunkWorkStats World::getWorkStats(const JobType type) const {
+	const ChunkWorkCounters& counters = workCounters[static_cast<size_t>(type)];
+
+	ChunkWorkStats stats;
+	stats.useful = counters.useful.load();
+	stats.cancelled = counters.cancelled.load();
+	stats.aborted = counters.aborted.load();
+	stats.discarded = counters.discarded.load();
+
+	return stats;
 }
 
 int World::getChunkCount() {
-	std::shared_lock lock(chunksMutex);
-	return static_cast<int>(chunks.size());
+	return grid.getLoadedCount();
+}
+
+// Walks every slot, meant for the debug UI rather than every frame
+size_t World::getVoxelMemoryUsage() {
+	size_t bytes = 0;
+
+	for (int i = 0; i < grid.getCapacity(); i++) {
+		ChunkSlot& slot = grid.getSlotAt(i);
+		if (!slot.hasChunk()) {
+			continue;
+		}
+
+		std::shared_ptr<Chunk> chunk = slot.chunk.load();
+		if (chunk) {
+			bytes += chunk->getMemoryUsage();
+		}
+	}
+
+	return bytes;
+}
+
+size_t World::getResidentBytes() const {
+	return grid.getResidentBytes();
 }
 
 int World::getRenderedChunkCount() {
@@ -277,330 +611,396 @@ glm::ivec3 World::getLocalPosition(const glm::ivec3& worldPosition) {
 ChunkNeighbors World::getChunkNeighbors(glm::ivec2 chunkIndex) {
 	ChunkNeighbors neighbors = {};
 
-	std::shared_lock lock(chunksMutex);
-
-	auto it = chunks.find(chunkIndex + DirectionVectors2D::PX);
-	if (it != chunks.end()) {
-		neighbors.px = it->second;
-	}
-
-	it = chunks.find(chunkIndex + DirectionVectors2D::NX);
-	if (it != chunks.end()) {
-		neighbors.nx = it->second;
-	}
-
-	it = chunks.find(chunkIndex + DirectionVectors2D::PZ);
-	if (it != chunks.end()) {
-		neighbors.pz = it->second;
-	}
-
-	it = chunks.find(chunkIndex + DirectionVectors2D::NZ);
-	if (it != chunks.end()) {
-		neighbors.nz = it->second;
-	}
+	neighbors.px = grid.getChunk(chunkIndex + DirectionVectors2D::PX);
+	neighbors.nx = grid.getChunk(chunkIndex + DirectionVectors2D::NX);
+	neighbors.pz = grid.getChunk(chunkIndex + DirectionVectors2D::PZ);
+	neighbors.nz = grid.getChunk(chunkIndex + DirectionVectors2D::NZ);
 
 	return neighbors;
 }
 
-void World::startGenerationThreads() {
-	std::call_once(startedGenerationThreads, [this]() {
-		// Create chunk generation threads
-		for (int i = 0; i < 4; i++) {
-			generationThreads.emplace_back([this, i]() {
-				tracy::SetThreadName(("Chunk Generation Thread " + std::to_string(i)).c_str());
+// LRU eviction of chunks outside the keep distance while over the memory budget
+// Scans the grid for candidates, then evicts the least recently used first, both spread over frames by a time budget
+void World::evictChunks(const glm::ivec2& centerChunkIndex, const int renderDistance) {
+	ZoneScopedN("Evict Chunks");
 
-				while (!stopGeneration.load()) {
-					ZoneScopedN("Process Chunk");
+	const auto deadline = std::chrono::steady_clock::now() + EVICTION_TIME_BUDGET;
+	const int keepDistance = renderDistance + EVICTION_HYSTERESIS;
 
-					glm::ivec2 chunkIndex;
+	// Working set budget, anything resident past the render window pushes it over and the hysteresis band decides what goes
+	// Chunks that far out are evicted here before a new chunk needs their slot (claim displacing them is the fallback)
+	effectiveMemoryBudget = memoryBudget;
+	if (effectiveMemoryBudget == 0) {
+		const int loadedCount = grid.getLoadedCount();
+		const size_t windowChunks = static_cast<size_t>(renderDistance * 2 + 1) * (renderDistance * 2 + 1);
 
-					// Get next chunk to generate
-					{
-						std::unique_lock<std::mutex> lock(generationQueueMutex);
-						generationCondition.wait(lock, [this] { return stopGeneration.load() || !generationQueue.empty(); });
-
-						if (stopGeneration.load()) {
-							break;
-						}
-
-						std::lock_guard<std::mutex> lock2(generationProcessingListMutex);
-
-						chunkIndex = generationQueue.top().second;
+		effectiveMemoryBudget = loadedCount > 0 ? windowChunks * (grid.getResidentBytes() / loadedCount) : std::numeric_limits<size_t>::max();
+	}
 
-						if (std::find(generationProcessingList.begin(), generationProcessingList.end(), chunkIndex) == generationProcessingList.end()) {
-							generationQueue.pop();
-							generationProcessingList.push_back(chunkIndex);
-						}
-						else {
-							continue;
-						}
-					}
+	// Under budget, start from scratch next time it's needed
+	if (grid.getResidentBytes() <= effectiveMemoryBudget) {
+		evictionCursor = 0;
+		evictionCandidates.clear();
+		evictionCandidateIndex = 0;
+		return;
+	}
 
-					// Generate chunk
-					generateChunk(chunkIndex);
+	// Scan
+	const int capacity = grid.getCapacity();
+	while (evictionCursor < capacity) {
+		ChunkSlot& slot = grid.getSlotAt(evictionCursor);
 
-					// Remove from processing list
-					std::lock_guard<std::mutex> lock(generationProcessingListMutex);
-					generationProcessingList.erase(std::remove(generationProcessingList.begin(), generationProcessingList.end(), chunkIndex), generationProcessingList.end());
-				}
-			});
+		if (slot.hasChunk() && !inWindow(grid.getSlotChunkIndex(slot), centerChunkIndex, keepDistance)) {
+			evictionCandidates.push_back({ slot.lastUsedFrame.load(), evictionCursor });
 		}
-	});
-}
 
-void World::startMeshingThreads() {
-	std::call_once(startedMeshingThreads, [this]() {
-		// Create chunk generation threads
-		for (int i = 0; i < 4; i++) {
-			meshingThreads.emplace_back([this, i]() {
-				tracy::SetThreadName(("Meshing Thread " + std::to_string(i)).c_str());
+		evictionCursor++;
 
-				while (!stopMeshing.load()) {
-					ZoneScopedN("Mesh Chunk");
+		if ((evictionCursor & 255) == 0 && std::chrono::steady_clock::now() >= deadline) {
+			return;
+		}
+	}
 
-					glm::ivec2 chunkIndex;
+	if (evictionCandidateIndex == 0) {
+		std::sort(evictionCandidates.begin(), evictionCandidates.end());
+	}
 
-					// Get next chunk to mesh
-					{
-						std::unique_lock<std::mutex> lock(meshingQueueMutex);
-						meshingCondition.wait(lock, [this] { return stopMeshing.load() || !meshingQueue.empty(); });
+	// Evict oldest first, skipping anything used or moved since the scan
+	while (evictionCandidateIndex < evictionCandidates.size() && grid.getResidentBytes() > effectiveMemoryBudget) {
+		const auto [lastUsedFrame, slotIndex] = evictionCandidates[evictionCandidateIndex++];
+		ChunkSlot& slot = grid.getSlotAt(slotIndex);
 
-						if (stopMeshing.load()) {
-							break;
-						}
+		const glm::ivec2 chunkIndex = grid.getSlotChunkIndex(slot);
+		if (slot.hasChunk() && slot.lastUsedFrame.load() == lastUsedFrame && !inWindow(chunkIndex, centerChunkIndex, keepDistance)) {
+			grid.evict(slot);
+			unlinkNeighbors(chunkIndex);
+			evictedCount++;
+		}
 
-						std::lock_guard<std::mutex> lock2(meshingProcessingListMutex);
+		if (std::chrono::steady_clock::now() >= deadline) {
+			return;
+		}
+	}
 
-						chunkIndex = meshingQueue.top().second;
+	// Candidates exhausted, rescan next frame if still over budget
+	evictionCursor = 0;
+	evictionCandidates.clear();
+	evictionCandidateIndex = 0;
+}
 
-						if (std::find(meshingProcessingList.begin(), meshingProcessingList.end(), chunkIndex) == meshingProcessingList.end()) {
-							meshingQueue.pop();
-							meshingProcessingList.push_back(chunkIndex);
-						}
-						else {
-							continue;
-						}
-					}
+void World::updateGenerationQueue(const glm::ivec3& worldPosition, const int renderDistance) {
+	ZoneScopedN("Update Generation Queue");
 
-					// Get chunk, queue should guarantee it exists
-					std::shared_ptr<Chunk> chunk;
-					{
-						std::shared_lock lock(chunksMutex);
-						auto it = chunks.find(chunkIndex);
-						if (it == chunks.end()) {
-							std::cerr << "Chunk doesn't exist!" << std::endl;
-							continue;
-						}
-						chunk = it->second;
-					}
+	glm::ivec2 centerChunkIndex = getChunkIndex(worldPosition);
 
-					// Get existing mesh or make a new one
-					std::shared_ptr<ChunkMesh> mesh;
-					{
-						std::unique_lock lock(meshesMutex);
-						auto it = meshes.find(chunkIndex);
-						if (it != meshes.end()) {
-							mesh = it->second;
-						}
-						else {
-							mesh = std::make_shared<ChunkMesh>();
-							meshes[chunkIndex] = mesh;
-						}
-					}
+	// Nothing to do until the camera crosses a chunk boundary
+	if (centerChunkIndex == queueCenter && renderDistance == queueDistance) {
+		return;
+	}
 
-					// Mesh
-					if (!mesh->isValid() || chunk->isDirty()) {
-						chunk->clearDirty();
-						mesh->build(chunk, getChunkNeighbors(chunkIndex));
-					}
+	const glm::ivec2 oldCenter = queueCenter;
+	const int oldDistance = queueDistance;
 
-					// Remove from processing list
-					std::lock_guard<std::mutex> lock(meshingProcessingListMutex);
-					meshingProcessingList.erase(std::remove(meshingProcessingList.begin(), meshingProcessingList.end(), chunkIndex), meshingProcessingList.end());
-				}
-				});
-		}
-		});
-}
+	queueCenter = centerChunkIndex;
+	queueDistance = renderDistance;
+	focusChunkKey.store(ChunkGrid::packKey(centerChunkIndex));
 
-void World::updateGenerationQueue(const glm::ivec3& worldPosition, const int renderDistance) {
-	ZoneScopedN("Update Generation Queue");
+	// Cancel queued work beyond the new window and drop requests in the ring that left it
+	const int cancelDistance = renderDistance + CANCEL_MARGIN;
+	cancelOutsideWindow(centerChunkIndex, cancelDistance);
 
-	startGenerationThreads();
+	if (oldDistance >= 0) {
+		const int oldCancelDistance = oldDistance + CANCEL_MARGIN;
 
-	std::priority_queue<std::pair<float, glm::ivec2>, std::vector<std::pair<float, glm::ivec2>>, ChunkQueueCompare> tempQueue;
+		for (int x = -oldCancelDistance; x <= oldCancelDistance; x++)
+		{
+			for (int z = -oldCancelDistance; z <= oldCancelDistance; z++)
+			{
+				glm::ivec2 current = oldCenter + glm::ivec2(x, z);
 
-	glm::ivec2 centerChunkIndex = getChunkIndex(worldPosition);
-	glm::vec2 worldPos2D(worldPosition.x, worldPosition.z);
+				if (inWindow(current, centerChunkIndex, cancelDistance)) {
+					continue;
+				}
 
-	std::lock_guard<std::mutex> processingLock(generationProcessingListMutex);
+				ChunkSlot* slot = grid.find(current);
+				if (slot) {
+					dropRequest(*slot);
+				}
+			}
+		}
+	}
 
-	// Add chunks within render distance to the generation queue
+	// Request anything in the window without a slot, not just the newly exposed ring (chunks that stayed in
+	// range can still have lost theirs to another chunk or had their request dropped), and mesh whatever had
+	// its meshing cancelled
 	for (int x = -renderDistance; x <= renderDistance; x++)
 	{
 		for (int z = -renderDistance; z <= renderDistance; z++)
 		{
 			glm::ivec2 current = centerChunkIndex + glm::ivec2(x, z);
 
-			// Skip if chunk has already been generated
-			{
-				std::shared_lock chunksLock(chunksMutex);
-				auto it = chunks.find(current);
-				if (it != chunks.end()) {
-					continue;
-				}
+			ChunkSlot* slot = grid.find(current);
+			if (!slot) {
+				requestChunk(current);
+				continue;
 			}
 
-			// Skip if chunk already being processed
-			if (std::find(generationProcessingList.begin(), generationProcessingList.end(), current) != generationProcessingList.end()) {
+			// Never meshed, or its remesh was cancelled (the chunk is still dirty)
+			const ChunkState state = slot->state.load();
+			if (slot->neighborMask.load() != ChunkSlot::ALL_NEIGHBORS || state < ChunkState::Generated || state == ChunkState::Meshing) {
 				continue;
 			}
 
-			// Calculate distance to chunk center in world space
-			glm::vec2 chunkCenterWorld = getChunkCenterWorld(current);
-			float distanceToChunkCenterWorld = glm::length(chunkCenterWorld - worldPos2D);
-
-			tempQueue.push(std::make_pair(-distanceToChunkCenterWorld, current));
+			std::shared_ptr<Chunk> chunk = slot->chunk.load();
+			if (state == ChunkState::Generated || (chunk && chunk->isDirty())) {
+				submitMesh(current, *slot, slot->generation.load());
+			}
 		}
 	}
 
-	// Swap the old gen queue with the new one
-	std::lock_guard<std::mutex> genLock(generationQueueMutex);
-	generationQueue = std::move(tempQueue);
+	// Jobs still queued were prioritized against the old center
+	const auto priorityFunction = [this](uint64_t tag) {
+		return getJobPriority(ChunkGrid::unpackKey(tag));
+	};
 
-	// Notify generation threads
-	generationCondition.notify_all();
+	jobSystem->reprioritize(JobType::Generation, priorityFunction);
+	jobSystem->reprioritize(JobType::Meshing, priorityFunction);
 }
 
-void World::updateMeshingQueue(const glm::ivec3& worldPosition, const int renderDistance) {
-	ZoneScopedN("Update Meshing Queue");
+// Closer chunks run first
+float World::getJobPriority(const glm::ivec2& chunkIndex) {
+	const glm::vec2 focusCenterWorld = getChunkCenterWorld(ChunkGrid::unpackKey(focusChunkKey.load()));
+	const glm::vec2 chunkCenterWorld = getChunkCenterWorld(chunkIndex);
 
-	startMeshingThreads();
+	return -glm::length(chunkCenterWorld - focusCenterWorld);
+}
 
-	std::priority_queue<std::pair<float, glm::ivec2>, std::vector<std::pair<float, glm::ivec2>>, ChunkQueueCompare> tempQueue;
+void World::requestChunk(const glm::ivec2& chunkIndex) {
+	uint32_t generation = 0;
+	std::optional<glm::ivec2> evictedIndex;
+	ChunkSlot* slot = &grid.claim(chunkIndex, generation, evictedIndex);
 
-	glm::ivec2 centerChunkIndex = getChunkIndex(worldPosition);
-	glm::vec2 worldPos2D(worldPosition.x, worldPosition.z);
+	// The chunk that aliased into this slot is gone, its neighbors can't count it anymore
+	if (evictedIndex) {
+		unlinkNeighbors(*evictedIndex);
+		displacedCount++;
+	}
 
-	std::lock_guard<std::mutex> processingLock(meshingProcessingListMutex);
+	jobSystem->submit(JobType::Generation, getJobPriority(chunkIndex), [this, chunkIndex, slot, generation]() {
+		generateChunk(chunkIndex, *slot, generation);
+	}, ChunkGrid::packKey(chunkIndex));
+}
 
-	// Add chunks within render distance to the meshing queue if they need an update
-	for (int x = -renderDistance; x <= renderDistance; x++)
-	{
-		for (int z = -renderDistance; z <= renderDistance; z++)
-		{
-			glm::ivec2 current = centerChunkIndex + glm::ivec2(x, z);
-			std::shared_ptr<Chunk> chunk;
+// Gives up a request that is queued or generating, generation jobs notice the new slot generation and stop
+void World::dropRequest(ChunkSlot& slot) {
+	const uint32_t generation = slot.generation.load();
 
-			// Skip if chunk hasn't been generated yet
-			{
-				std::shared_lock chunksLock(chunksMutex);
+	if (grid.transition(slot, generation, ChunkState::Requested, ChunkState::Evicting) || grid.transition(slot, generation, ChunkState::Generating, ChunkState::Evicting)) {
+		grid.release(slot, generation);
+	}
+}
 
-				auto it = chunks.find(current);
-				if (it == chunks.end()) {
-					continue;
-				}
-				chunk = it->second;
-			}
+// Pulls queued jobs for chunks outside the window out of the job system before they run
+void World::cancelOutsideWindow(const glm::ivec2& centerChunkIndex, const int cancelDistance) {
+	const auto outsideWindow = [centerChunkIndex, cancelDistance](uint64_t tag) {
+		return !inWindow(ChunkGrid::unpackKey(tag), centerChunkIndex, cancelDistance);
+	};
 
-			// Skip if neighbors haven't been generated yet
-			{
-				ChunkNeighbors neighbors = getChunkNeighbors(current);
+	// Dropped requests can be claimed again if the chunk comes back into range
+	for (const uint64_t tag : jobSystem->cancel(JobType::Generation, outsideWindow)) {
+		ChunkSlot* slot = grid.find(ChunkGrid::unpackKey(tag));
+		if (slot) {
+			dropRequest(*slot);
+		}
 
-				if (!neighbors.px || !neighbors.nx || !neighbors.pz || !neighbors.nz) {
-					continue;
-				}
-			}
+		getWorkCounters(JobType::Generation).cancelled++;
+	}
 
-			// Skip if mesh exists and doesn't need an update
-			{
-				std::shared_lock meshesLock(meshesMutex);
+	// Chunks go back to the state they were in (an existing mesh keeps drawing), they're resubmitted if they come back into range
+	for (const uint64_t tag : jobSystem->cancel(JobType::Meshing, outsideWindow)) {
+		ChunkSlot* slot = grid.find(ChunkGrid::unpackKey(tag));
+		if (slot) {
+			grid.transition(*slot, slot->generation.load(), ChunkState::Meshing, slot->stateBeforeMeshing.load());
+		}
 
-				auto it = meshes.find(current);
-				if (it != meshes.end()) {
-					if (!chunk->isDirty()) {
-						continue;
-					}
-				}
-			}
+		getWorkCounters(JobType::Meshing).cancelled++;
+	}
+}
 
-			// Skip if mesh is already being processed
-			if (std::find(meshingProcessingList.begin(), meshingProcessingList.end(), current) != meshingProcessingList.end()) {
-				continue;
+// Marks the freshly generated chunk and its generated neighbors as present to each other, meshing whichever became complete
+void World::linkNeighbors(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation) {
+	for (int i = 0; i < 4; i++) {
+		const glm::ivec2 neighborIndex = chunkIndex + DirectionVectors2D::arr[i];
+
+		ChunkSlot* neighbor = grid.find(neighborIndex);
+		if (!neighbor || !neighbor->hasChunk()) {
+			continue;
+		}
+
+		// Checked again under the slot mutexes, the main thread may have reassigned either slot since
+		uint32_t neighborGeneration = 0;
+		uint8_t previous = 0;
+		if (!grid.linkNeighbor(slot, generation, i, neighborIndex, neighborGeneration, previous)) {
+			continue;
+		}
+
+		if (previous != ChunkSlot::ALL_NEIGHBORS && (previous | (1u << (i ^ 1))) == ChunkSlot::ALL_NEIGHBORS) {
+			// Its border faces were built against a missing chunk, every section touches the border
+			if (std::shared_ptr<Chunk> neighborChunk = neighbor->chunk.load()) {
+				neighborChunk->markSectionsDirty(ALL_SECTIONS);
 			}
 
-			// Calculate distance to chunk center in world space
-			glm::vec2 chunkCenterWorld = getChunkCenterWorld(current);
-			float distanceToChunkCenterWorld = glm::length(chunkCenterWorld - worldPos2D);
+			submitMesh(neighborIndex, *neighbor, neighborGeneration);
+		}
+	}
 
-			tempQueue.push(std::make_pair(-distanceToChunkCenterWorld, current));
+	if (slot.neighborMask.load() == ChunkSlot::ALL_NEIGHBORS) {
+		submitMesh(chunkIndex, slot, generation);
+	}
+}
+
+// Clears the evicted chunk from its neighbors' masks (main thread only)
+void World::unlinkNeighbors(const glm::ivec2& chunkIndex) {
+	for (int i = 0; i < 4; i++) {
+		ChunkSlot* neighbor = grid.find(chunkIndex + DirectionVectors2D::arr[i]);
+		if (neighbor) {
+			neighbor->neighborMask.fetch_and(uint8_t(~(1u << (i ^ 1))));
 		}
 	}
+}
+
+// Moves the chunk into meshing and queues the job, no-op if it's not generated yet or already meshing
+// True if the job was queued here
+bool World::submitMesh(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation) {
+	while (true) {
+		const ChunkState state = slot.state.load();
+		if (state != ChunkState::Generated && state != ChunkState::Meshed && state != ChunkState::Uploaded) {
+			return false;
+		}
 
-	// Swap the old mesh queue with the new one
-	std::lock_guard<std::mutex> meshLock(meshingQueueMutex);
-	meshingQueue = std::move(tempQueue);
+		// Retry if the main thread moved it Meshed -> Uploaded in between, give up if the slot was reassigned
+		// Nothing else moves it out of Meshing before the job is queued, so the state is recorded after
+		if (grid.transition(slot, generation, state, ChunkState::Meshing)) {
+			slot.stateBeforeMeshing.store(state);
+			break;
+		}
+
+		if (slot.generation.load() != generation) {
+			return false;
+		}
+	}
 
-	// Notify generation threads
-	meshingCondition.notify_all();
+	ChunkSlot* slotPtr = &slot;
+	jobSystem->submit(JobType::Meshing, getJobPriority(chunkIndex), [this, chunkIndex, slotPtr, generation]() {
+		meshChunk(chunkIndex, *slotPtr, generation);
+	}, ChunkGrid::packKey(chunkIndex));
+
+	return true;
+}
+
+// Remeshes an edited chunk right away if it already has a mesh (first meshes pick up edits on their own)
+// True if a mesh is on its way, either submitted here or already running (and resubmitted for the dirty chunk)
+bool World::requestRemesh(const glm::ivec2& chunkIndex) {
+	ChunkSlot* slot = grid.find(chunkIndex);
+	if (!slot || slot->neighborMask.load() != ChunkSlot::ALL_NEIGHBORS) {
+		return false;
+	}
+
+	// A fast worker can finish the submitted job before the state is read back, so trust the submit
+	const ChunkState state = slot->state.load();
+	if ((state == ChunkState::Meshed || state == ChunkState::Uploaded) && submitMesh(chunkIndex, *slot, slot->generation.load())) {
+		return true;
+	}
+
+	return slot->state.load() == ChunkState::Meshing;
 }
 
 // Generates a chunk at the given chunk index based on the world's generation type
-void World::generateChunk(const glm::ivec2& chunkIndex) {
+void World::generateChunk(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation) {
 	ZoneScopedN("Generate Chunk");
 
-	// Check if a chunk already exists at index
-	{
-		std::lock_guard lock(chunksMutex);
+	ChunkWorkCounters& counters = getWorkCounters(JobType::Generation);
 
-		if (chunks.contains(chunkIndex)) {
-			std::cerr << "Tried generating chunk at " << chunkIndex.x << ", " << chunkIndex.y << " but it already exists!" << std::endl;
-			return;
-		}
+	// Claim the slot, fails if it was evicted or reassigned while queued
+	if (!grid.transition(slot, generation, ChunkState::Requested, ChunkState::Generating)) {
+		counters.cancelled++;
+		return;
 	}
 
-	// Generate chunk data
-	std::shared_ptr<Chunk> chunk;
+	// Dropped requests bump the slot generation
+	const auto isCancelled = [&slot, generation]() {
+		return slot.generation.load() != generation;
+	};
+
+	// Generate chunk data into this worker's scratch volume
+	VoxelVolume& volume = ChunkPool::getScratchVolume();
+	bool completed = true;
+
 	switch (generationType) {
 		case GenerationType::Flat:
-			chunk = std::make_shared<Chunk>(std::move(*Generation::generateFlat()));
+			Generation::generateFlat(volume);
 			break;
 		case GenerationType::Simple:
-			chunk = std::make_shared<Chunk>(std::move(*Generation::generateSimple(seed, chunkIndex)));
+			Generation::generateSimple(seed, chunkIndex, volume);
 			break;
 		case GenerationType::Advanced:
-			chunk = std::make_shared<Chunk>(std::move(*Generation::generateAdvanced(seed, chunkIndex)));
+			completed = Generation::generateAdvanced(seed, chunkIndex, volume, isCancelled);
 			break;
 		default:
 			throw std::runtime_error("Invalid generation type!");
 			break;
 	}
 
+	if (!completed) {
+		counters.aborted++;
+		return;
+	}
+
+	std::shared_ptr<Chunk> chunk = chunkPool.acquire(volume);
+
+	// Publish, fails if the slot was evicted while generating
 	{
 		ZoneScopedN("Insert");
-		std::lock_guard lock(chunksMutex);
-
-		chunks.insert({ chunkIndex, chunk });
+		if (!grid.publishChunk(slot, generation, std::move(chunk))) {
+			counters.discarded++;
+			return;
+		}
 	}
+
+	counters.useful++;
+
+	// This chunk and its neighbors may now have everything they need to mesh
+	linkNeighbors(chunkIndex, slot, generation);
 }
 
-bool World::frustrumAABBVisibility(const glm::ivec2& chunkIndex, const std::vector<glm::vec4>& frustrumPlanes) {
-	glm::vec4 vmin = glm::vec4(chunkIndex.x * CHUNK_SIZE, 0, chunkIndex.y * CHUNK_SIZE, 1.0f);
-	glm::vec4 vmax = vmin + glm::vec4(CHUNK_SIZE, MAX_HEIGHT, CHUNK_SIZE, 0.0f);
+// Builds (or rebuilds) the mesh for the chunk in the given slot
+void World::meshChunk(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation) {
+	ZoneScopedN("Mesh Chunk");
 
-	for (const glm::vec4& plane : frustrumPlanes) {
-		if ((glm::dot(plane, vmin) < 0.0f) &&
-			(glm::dot(plane, glm::vec4(vmax.x, vmin.y, vmin.z, 1.0f)) < 0.0f) &&
-			(glm::dot(plane, glm::vec4(vmin.x, vmax.y, vmin.z, 1.0f)) < 0.0f) &&
-			(glm::dot(plane, glm::vec4(vmax.x, vmax.y, vmin.z, 1.0f)) < 0.0f) &&
-			(glm::dot(plane, glm::vec4(vmin.x, vmin.y, vmax.z, 1.0f)) < 0.0f) &&
-			(glm::dot(plane, glm::vec4(vmax.x, vmin.y, vmax.z, 1.0f)) < 0.0f) &&
-			(glm::dot(plane, glm::vec4(vmin.x, vmax.y, vmax.z, 1.0f)) < 0.0f) &&
-			(glm::dot(plane, vmax) < 0.0f))
-		{
-			return false;
-		}
+	std::shared_ptr<Chunk> chunk = slot.chunk.load();
+	std::shared_ptr<ChunkMesh> mesh = slot.mesh.load();
+
+	ChunkWorkCounters& counters = getWorkCounters(JobType::Meshing);
+
+	// Skip if evicted or reassigned while queued
+	if (slot.generation.load() != generation || slot.state.load() != ChunkState::Meshing || !chunk || !mesh) {
+		counters.cancelled++;
+		return;
 	}
 
-	return true;
-}
+	// Mesh, only the sections edited (or relinked to a neighbor) since the last build once the mesh exists
+	mesh->build(chunk, getChunkNeighbors(chunkIndex), chunk->takeDirtySections());
+
+	// Fails if evicted while meshing
+	if (!grid.transition(slot, generation, ChunkState::Meshing, ChunkState::Meshed)) {
+		counters.discarded++;
+		return;
+	}
+
+	counters.useful++;
+
+	// Edited while meshing, needs another pass
+	if (chunk->isDirty()) {
+		submitMesh(chunkIndex, slot, generation);
+	}
+}
\ No newline at end of file
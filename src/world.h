@@ -3,19 +3,22 @@
 #include "shader.h"
 #include "chunk.h"
 #include "chunkMesh.h"
+#include "chunkGrid.h"
+#include "chunkPool.h"
 #include "structs.h"
+#include "jobSystem.h"
+#include "softwareOcclusion.h"
+#include "frustum.h"
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
-#include <unordered_map>
 #include <memory>
-#include <queue>
-#include <unordered_set>
 #include <utility>
-#include <mutex>
-#include <shared_mutex>
 #include <atomic>
-#include <thread>
-#include <condition_variable>
+#include <array>
+#include <cstdlib>
+#include <chrono>
+#include <span>
+#include <unordered_set>
 
 struct ChunkDrawingInfo {
 	std::shared_ptr<ChunkMesh> mesh;
@@ -23,82 +26,241 @@ struct ChunkDrawingInfo {
 	float distance;
 };
 
+// Outcome counts of chunk jobs, cancelled jobs never started while aborted and discarded ones are wasted work
+struct ChunkWorkStats {
+	uint64_t useful = 0;
+	uint64_t cancelled = 0;
+	uint64_t aborted = 0;
+	uint64_t discarded = 0;
+};
+
+// Multi chunk edit batches, held uploads count chunks that kept their old mesh for a frame while their batch finished
+struct EditBatchStats {
+	uint64_t released = 0;
+	uint64_t timedOut = 0;
+	uint64_t heldUploads = 0;
+};
+
+// Time from an edit until every chunk it remeshed has its new mesh uploaded
+struct EditLatencyStats {
+	uint64_t count = 0;
+	uint64_t timedOut = 0;
+	std::chrono::microseconds last = std::chrono::microseconds(0);
+	std::chrono::microseconds average = std::chrono::microseconds(0);
+	std::chrono::microseconds max = std::chrono::microseconds(0);
+};
+
 class World {
 public:
-	World(const GenerationType generationType, const uint32_t seed);
+	World(FacePool& facePool, const GenerationType generationType, const uint32_t seed, const int maxRenderDistance = MAX_RENDER_DISTANCE, const unsigned int workerCount = 0);
 	~World();
 
 	void update(const glm::ivec3& worldPosition, const int renderDistance, const glm::mat4& view, const glm::mat4& projection);
-	void drawOpaque(const glm::ivec3& worldPosition, const int renderDistance, const glm::mat4& view, const glm::mat4& projection, Shader& shader, const bool wireframe = false);
-	void drawWater(const glm::ivec3& worldPosition, const int renderDistance, const glm::mat4& view, const glm::mat4& projection, Shader& shader, const bool wireframe = false);
+	void drawOpaque(const glm::ivec3& worldPosition, const int renderDistance, const bool wireframe = false);
+	void drawWater(const glm::ivec3& worldPosition, const int renderDistance, const bool wireframe = false);
+
+	// Frustum culls the chunks gathered by update on the GPU, call with the cull shader bound before drawing
+	void cullChunks(const Shader& cullShader);
+
+	// GPU culling leaves the draw list unculled on the CPU, rendered counts are candidates then
+	bool isGpuCullingEnabled() const { return gpuCullingEnabled; }
+	void setGpuCullingEnabled(const bool enabled) { gpuCullingEnabled = enabled; }
+
+	// Hi-Z occlusion on top of GPU frustum culling, the renderer's pyramid must be bound for the cull
+	bool isOcclusionCullingEnabled() const { return occlusionCullingEnabled; }
+	void setOcclusionCullingEnabled(const bool enabled) { occlusionCullingEnabled = enabled; }
+
+	// CPU occlusion against nearby terrain, used in place of the GPU passes when GPU culling is off
+	bool isSoftwareOcclusionEnabled() const { return softwareOcclusionEnabled; }
+	void setSoftwareOcclusionEnabled(const bool enabled) { softwareOcclusionEnabled = enabled; }
+	size_t getSoftwareOccludedCount() const { return softwareOccludedCount; }
 
 	ChunkNeighbors getChunkNeighbors(glm::ivec2 chunkIndex);
 
 	void updateGenerationQueue(const glm::ivec3& worldPosition, const int renderDistance);
-	void updateMeshingQueue(const glm::ivec3& worldPosition, const int renderDistance);
 
 	bool hasVoxel(const glm::ivec3& position);
-	void addVoxel(const glm::ivec3& position);
+	void addVoxel(const glm::ivec3& position, const VoxelType type = VoxelType::STONE);
 	void removeVoxel(const glm::ivec3& position);
 
+	// Batched edits in world space, each touched chunk is locked and remeshed once
+	void applyEdits(const std::span<const VoxelEdit> edits);
+	void fillBox(const glm::ivec3& min, const glm::ivec3& max, const VoxelType type);
+	void fillSphere(const glm::ivec3& center, const int radius, const VoxelType type);
+	EditBatchStats getEditBatchStats() const { return editBatchStats; }
+	EditLatencyStats getEditLatencyStats() const { return editLatencyStats; }
+
 	int getChunkCount();
+	size_t getVoxelMemoryUsage();
+	size_t getResidentBytes() const;
+	// A budget of 0 follows the working set (the render window at the average resident chunk size)
+	size_t getMemoryBudget() const { return memoryBudget; }
+	void setMemoryBudget(const size_t bytes) { memoryBudget = bytes; }
+	size_t getEffectiveMemoryBudget() const { return effectiveMemoryBudget; }
+	// Chunks evicted by LRU, and ones pushed out of their slot by a new chunk before LRU got to them
+	uint64_t getEvictedCount() const { return evictedCount; }
+	uint64_t getDisplacedCount() const { return displacedCount; }
+	ChunkPoolStats getChunkPoolStats() const { return chunkPool.getStats(); }
 	int getRenderedChunkCount();
+	size_t getRenderedFaceCount() const { return renderedFaceCount; }
+	size_t getRenderedUnmergedFaceCount() const { return renderedUnmergedFaceCount; }
 	glm::ivec2 getChunkIndex(const glm::ivec3& worldPosition);
 	glm::ivec2 getChunkCenterWorld(const glm::ivec2& chunkIndex);
 	glm::ivec3 getLocalPosition(const glm::ivec3& worldPosition);
 
+	JobSystemStats getJobStats() const { return jobSystem->getStats(); }
+	ChunkWorkStats getWorkStats(const JobType type) const;
+
 private:
-	void startMeshingThreads();
-	void startGenerationThreads();
+	// Every chunk mesh lives in here, owned by the scene so it outlives them
+	FacePool& facePool;
 
-	// Chunks
-	std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>, ivec2Hasher> chunks;
-	std::shared_mutex chunksMutex;
+	// Unloaded chunks kept around for reuse
+	static constexpr size_t CHUNK_POOL_SIZE = 512;
+	ChunkPool chunkPool;
 
-	// Meshes
-	std::unordered_map<glm::ivec2, std::shared_ptr<ChunkMesh>, ivec2Hasher> meshes;
-	std::shared_mutex meshesMutex;
+	// Chunk slots
+	ChunkGrid grid;
 
-	// Generation
-	std::priority_queue<std::pair<float, glm::ivec2>, std::vector<std::pair<float, glm::ivec2>>, ChunkQueueCompare> generationQueue;
-	std::mutex generationQueueMutex;
+	// Eviction
+	static constexpr int EVICTION_HYSTERESIS = 4;
+	static constexpr std::chrono::microseconds EVICTION_TIME_BUDGET = std::chrono::microseconds(500);
+	static constexpr std::chrono::microseconds MESH_DELETION_TIME_BUDGET = std::chrono::microseconds(250);
 
-	std::vector<glm::ivec2> generationProcessingList;
-	std::mutex generationProcessingListMutex;
+	size_t memoryBudget = 0;
+	size_t effectiveMemoryBudget = 0;
+	uint64_t frameIndex = 0;
+	uint64_t evictedCount = 0;
+	uint64_t displacedCount = 0;
 
-	std::vector<std::thread> generationThreads;
-	std::condition_variable generationCondition;
-	std::atomic<bool> stopGeneration = false;
-	std::once_flag startedGenerationThreads;
+	// Scan position and (last used frame, slot index) candidates, carried across frames
+	int evictionCursor = 0;
+	std::vector<std::pair<uint64_t, int>> evictionCandidates;
+	size_t evictionCandidateIndex = 0;
 
+	// Queue window, only changes when the camera crosses a chunk boundary
+	glm::ivec2 queueCenter = glm::ivec2(0);
+	int queueDistance = -1;
+
+	// Center chunk jobs are prioritized against (read by workers submitting mesh jobs)
+	std::atomic<uint64_t> focusChunkKey = 0;
+
+	// Generation
 	GenerationType generationType = GenerationType::Flat;
 	uint32_t seed = 0;
 
-	// Meshing
-	std::priority_queue<std::pair<float, glm::ivec2>, std::vector<std::pair<float, glm::ivec2>>, ChunkQueueCompare> meshingQueue;
-	std::mutex meshingQueueMutex;
+	// Jobs
+	std::unique_ptr<JobSystem> jobSystem;
 
-	std::vector<glm::ivec2> meshingProcessingList;
-	std::mutex meshingProcessingListMutex;
+	struct ChunkWorkCounters {
+		std::atomic<uint64_t> useful = 0;
+		std::atomic<uint64_t> cancelled = 0;
+		std::atomic<uint64_t> aborted = 0;
+		std::atomic<uint64_t> discarded = 0;
+	};
 
-	std::vector<std::thread> meshingThreads;
-	std::condition_variable meshingCondition;
-	std::atomic<bool> stopMeshing = false;
-	std::once_flag startedMeshingThreads;
+	std::array<ChunkWorkCounters, static_cast<size_t>(JobType::COUNT)> workCounters;
+
+	// Chunks this far past the render distance keep their work, so jittering over a boundary doesn't thrash
+	static constexpr int CANCEL_MARGIN = 1;
 	
+	// Chunks remeshed by one border edit, uploaded in the same frame so both sides of the face change together
+	struct EditBatch {
+		std::vector<std::pair<glm::ivec2, uint32_t>> chunks;
+		uint64_t startFrame = 0;
+	};
+
+	static constexpr uint64_t EDIT_BATCH_MAX_FRAMES = 30;
+
+	std::vector<EditBatch> editBatches;
+	EditBatchStats editBatchStats;
+
+	// Keys of chunks in unfinished batches, rebuilt by updateEditBatches and looked up per chunk every frame
+	std::unordered_set<uint64_t> heldChunkKeys;
+
+	// Edits whose remeshed chunks aren't all uploaded yet, given up on after the timeout
+	struct EditLatencyProbe {
+		std::vector<std::pair<glm::ivec2, uint32_t>> chunks;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+	static constexpr std::chrono::seconds EDIT_LATENCY_TIMEOUT = std::chrono::seconds(5);
+
+	std::vector<EditLatencyProbe> editLatencyProbes;
+	EditLatencyStats editLatencyStats;
+
 	// Drawing
 	std::vector<ChunkDrawingInfo> chunksToDraw;
 	size_t renderedChunkCount = 0;
 
-	void resetGenerationQueue() {
-		generationQueue = std::priority_queue<std::pair<float, glm::ivec2>, std::vector<std::pair<float, glm::ivec2>>, ChunkQueueCompare>();
-	}
+	// Per section bounds of the chunks in chunksToDraw, and where each chunk's boxes end (CPU frustum culling)
+	AABBBatch sectionBounds;
+	std::vector<uint32_t> sectionBoundsEnd;
+	std::vector<uint8_t> sectionVisible;
+
+	// Reused each pass to build the face pool multi-draw
+	std::vector<DrawArraysIndirectCommand> drawCommands;
+	std::vector<glm::vec4> drawOffsets;
+
+	bool gpuCullingEnabled = true;
+	bool occlusionCullingEnabled = true;
+	std::vector<ChunkCullInput> cullInputs;
+
+	// Software occlusion, occluders come from the closest chunks drawn last frame
+	static constexpr size_t MAX_OCCLUDER_CHUNKS = 64;
 
-	void resetMeshingQueue() {
-		meshingQueue = std::priority_queue<std::pair<float, glm::ivec2>, std::vector<std::pair<float, glm::ivec2>>, ChunkQueueCompare>();
+	enum class OcclusionJobState : uint8_t {
+		Idle,
+		Queued,
+		Running,
+		Done,
+	};
+
+	bool softwareOcclusionEnabled = false;
+	SoftwareOcclusion softwareOcclusion;
+	std::vector<OccluderBox> occluders;
+	glm::mat4 occlusionViewProjection = glm::mat4(1.0f);
+	glm::vec3 occlusionCameraPosition = glm::vec3(0.0f);
+	std::atomic<OcclusionJobState> occlusionJobState = OcclusionJobState::Idle;
+	size_t softwareOccludedCount = 0;
+
+	// Greedy quads drawn this frame, and the per-voxel faces they stand in for
+	size_t renderedFaceCount = 0;
+	size_t renderedUnmergedFaceCount = 0;
+
+	void evictChunks(const glm::ivec2& centerChunkIndex, const int renderDistance);
+
+	float getJobPriority(const glm::ivec2& chunkIndex);
+
+	void requestChunk(const glm::ivec2& chunkIndex);
+	void dropRequest(ChunkSlot& slot);
+	void cancelOutsideWindow(const glm::ivec2& centerChunkIndex, const int cancelDistance);
+	void linkNeighbors(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation);
+	void unlinkNeighbors(const glm::ivec2& chunkIndex);
+	bool submitMesh(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation);
+	bool requestRemesh(const glm::ivec2& chunkIndex);
+	void updateEditBatches();
+	void updateEditLatency(const Frustum& frustum);
+	void drawChunks(const bool liquid, const bool wireframe);
+
+	void cullFrustum(const Frustum& frustum);
+	void submitOcclusion(const glm::vec3& cameraPosition, const glm::mat4& viewProjection);
+	void renderOccluders();
+	void cullOccluded();
+
+	void generateChunk(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation);
+	void meshChunk(const glm::ivec2& chunkIndex, ChunkSlot& slot, const uint32_t generation);
+
+	ChunkWorkCounters& getWorkCounters(const JobType type) {
+		return workCounters[static_cast<size_t>(type)];
 	}
 
-	void generateChunk(const glm::ivec2& chunkIndex);
+	static bool inWindow(const glm::ivec2& chunkIndex, const glm::ivec2& centerChunkIndex, const int distance) {
+		return std::abs(chunkIndex.x - centerChunkIndex.x) <= distance && std::abs(chunkIndex.y - centerChunkIndex.y) <= distance;
+	}
 
-	static bool frustrumAABBVisibility(const glm::ivec2& chunkIndex, const std::vector<glm::vec4>& frustrumPlanes);
+	// Grid radius, leaves room for chunks kept past the render distance until the budget evicts them
+	static int getGridRadius(const int renderDistance) {
+		return static_cast<int>(renderDistance * 1.5f);
+	}
 };
\ No newline at end of file